@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   Pierre Michaud, "Best-Offset Hardware Prefetching", HPCA 2016
+ *
+ * Best-offset prefetching: candidate offsets are scored in rounds against a
+ * table of recent requests, and every miss or first hit on a prefetched
+ * block prefetches at the best one. Prefetching stops while no offset
+ * scores above BO_BAD_SCORE. Build with -DBO_DEGREE=n to prefetch more
+ * than one multiple of the offset.
+ */
+
+#include "interface.hh"
+
+/* ---------------------------------------------------------------- Logging */
+#include "prefetch_log.hh"
+
+/* --------------------------------------------------------------- Pipeline */
+#include "prefetch_pipeline.hh"
+#include "prefetch_instances.hh"
+#include "stage_best_offset.hh"
+
+typedef PrefetchPipeline<BestOffsetTrainer, BestOffsetPredictor> Prefetcher;
+
+PrefetcherInstances<Prefetcher> prefetchers;
+
+/* --------------------------------- Standard hardware prefetcher interface */
+void prefetch_init(void)
+{
+    LOGD("prefetch_init");
+
+    prefetchers.Current().Init();
+}
+
+void prefetch_access(AccessStat stat)
+{
+    LOG_SET_TIME(stat.time);
+
+    LOGD("prefetch_access: addr = 0x%016x, pc = 0x%016x, miss = %d",
+         stat.mem_addr, stat.pc, stat.miss);
+
+    prefetchers.Current().Access(stat);
+}
+
+void prefetch_complete(Addr addr)
+{
+    LOGD("prefetch_complete: addr = 0x%016x, current_queue_size = %d",
+         addr, current_queue_size());
+
+    prefetchers.Current().Complete(addr);
+}
+
+void prefetch_final(void)
+{
+    Prefetcher& prefetcher = prefetchers.Current();
+
+    const BestOffsetTrainer& bo = prefetcher.GetTrainer();
+
+    fprintf(stderr, "best-offset: offset %d, %d learning phases, %d off\n",
+            bo.Offset(), bo.Phases(), bo.PhasesOff());
+
+    prefetcher.Print(stderr, "best-offset");
+    LOG_EVENT_DUMP();
+}
+
+/* Only called by the benchmarks */
+double prefetch_occupancy(void)
+{
+    return prefetchers.Current().Occupancy();
+}
+
+/* Only called by the simulator, same as prefetch_access on every access */
+void prefetch_access_batch(const AccessBatch& batch, AccessDemand demand,
+                           void* context)
+{
+    prefetchers.Current().Access(batch, demand, context);
+}
+
+/* Only called by the simulator, which creates an instance per cache */
+PREFETCH_INSTANCE_FUNCTIONS(prefetchers)
@@ -0,0 +1,34 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Batched entry point of the prefetchers, for the offline replays. M5 does
+ * not know about it and only ever calls prefetch_access.
+ */
+
+#pragma once
+
+/* Accesses of a batch, as a structure of arrays */
+struct AccessBatch
+{
+    int count;
+    const Addr* pc;
+    const Addr* mem_addr;
+    const Tick* time;
+    int* miss; /* Filled by demand, see below */
+};
+
+/* Called right before the prefetcher sees access i of the batch, so that
+   the cache serves it, lands the prefetches completed until then and sets
+   miss[i] */
+typedef void (*AccessDemand)(void* context, int i);
+
+/* Optional, only called by the simulator. Same as prefetch_access on every
+   access of the batch in turn, but what only depends on the accesses
+   themselves is computed for the whole batch first. */
+void prefetch_access_batch(const AccessBatch& batch, AccessDemand demand,
+                           void* context) __attribute__((weak));
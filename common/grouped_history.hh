@@ -0,0 +1,483 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#ifndef ADDR
+#  define ADDR uint64_t
+#endif /* ADDR */
+
+#ifndef TICK
+#  define TICK int64_t
+#endif /* TICK */
+
+#ifndef LOG
+#  include <cstdio>
+#
+#  define LOG(...) printf(__VA_ARGS__); printf("\n")
+#  define LOGD(...) LOG(__VA_ARGS__)
+#  define LOGE(...) LOG(__VA_ARGS__)
+#endif /* LOG */
+
+#ifndef MAXOF
+#   define MAXOF(a, b) (((a) > (b)) ? (a) : (b))
+#endif /* MAXOF */
+
+template <typename T>
+struct GroupedHistoryEntry
+{
+    ADDR FirstAddr;
+    ADDR LastAddr;
+    TICK LastAccess;
+    T Data;
+};
+
+template <typename T>
+class GroupedHistoryCallbacks
+{
+public:
+    virtual bool CanMerge(const GroupedHistoryEntry<T>& a,
+                          const GroupedHistoryEntry<T>& b) = 0;
+};
+
+/**
+ * History of address intervals, ordered by address and evicted in order of
+ * last access.
+ *
+ * All the entries live in a slab allocated once by the constructor and are
+ * linked by index: a treap keyed by FirstAddr serves the address lookups
+ * and a doubly-linked list ordered by LastAccess serves the eviction. No
+ * allocation happens after construction.
+ */
+template <typename T>
+class GroupedHistory
+{
+private:
+    typedef GroupedHistoryEntry<T> Entry;
+
+    enum { NIL = -1 };
+
+    struct Node
+    {
+        Entry Value;
+
+        int Left;      // Address treap
+        int Right;
+        uint32_t Priority;
+
+        int Prev;      // Time ordered list, also the free list
+        int Next;
+    };
+
+private:
+    GroupedHistoryCallbacks<T>& mCallbacks;
+    int mBlockSize;
+    int mCapacity;
+
+    std::vector<Node> mNodes;
+    int mSize;
+    int mFree;
+    int mRoot;
+    int mOldest;
+    int mNewest;
+    uint32_t mSeed;
+
+public:
+    GroupedHistory<T>(GroupedHistoryCallbacks<T>& callbacks,
+                      int blockSize, int capacity)
+        : mCallbacks(callbacks), mBlockSize(blockSize), mCapacity(capacity)
+    {
+        // An update adds at most two entries before evicting the old ones
+        mNodes.resize(capacity + 2);
+        Clear();
+    }
+
+    // Removes all the entries, without any allocation
+    void Clear()
+    {
+        mSize = 0;
+        mFree = NIL;
+        mRoot = NIL;
+        mOldest = NIL;
+        mNewest = NIL;
+        mSeed = 2463534242u;
+
+        for (int i = (int)mNodes.size() - 1; i >= 0; --i)
+        {
+            mNodes[i].Next = mFree;
+            mFree = i;
+        }
+    }
+
+    void Update(TICK accessTime, ADDR addr, const T& data)
+    {
+        Entry* prevEntry;
+
+        // Checks whether this address is inside an existing entry in history
+        // If yes, tries to either merge them or split the old one into two
+        // and insert the new one in between.
+        int idx = FindEntryByAddr(addr);
+
+        if (idx != NIL)
+        {
+            prevEntry = &mNodes[idx].Value;
+
+            Entry newEntry;
+            newEntry.FirstAddr = addr;
+            newEntry.LastAddr = addr;
+            newEntry.LastAccess = accessTime;
+            newEntry.Data = data;
+
+            if (mCallbacks.CanMerge(*prevEntry, newEntry))
+            {
+                UpdateLastAccess(idx, accessTime);
+            }
+            else
+            {
+                // Splits the previous entry into two parts
+                if (addr + mBlockSize <= prevEntry->LastAddr)
+                    AddNewEntry(addr + mBlockSize,
+                                prevEntry->LastAddr,
+                                prevEntry->LastAccess,
+                                prevEntry->Data, idx);
+
+                if (prevEntry->FirstAddr + mBlockSize <= addr)
+                    prevEntry->LastAddr = addr - mBlockSize;
+                else RemoveEntry(idx);
+            }
+        }
+
+        // If the entry cannot be merged with an existing one, creates new one
+        if (FindEntryByAddr(addr) == NIL)
+        {
+            idx = AddNewEntry(addr, addr, accessTime, data, NIL);
+
+            // Tries to merge with the previous entry
+            int prevIdx = (idx != NIL) ? FindPrev(addr) : NIL;
+
+            if (prevIdx != NIL)
+            {
+                Entry& prev = mNodes[prevIdx].Value;
+
+                if (mCallbacks.CanMerge(prev, mNodes[idx].Value))
+                {
+                    prev.LastAddr = mNodes[idx].Value.LastAddr;
+                    UpdateLastAccess(prevIdx, accessTime);
+                    RemoveEntry(idx);
+                }
+            }
+
+            // Tries to merge with the next entry
+            prevIdx = FindEntryByAddr(addr);
+            idx = (prevIdx != NIL)
+                ? FindNext(mNodes[prevIdx].Value.FirstAddr) : NIL;
+
+            if (idx != NIL)
+            {
+                Entry& prev = mNodes[prevIdx].Value;
+
+                if (mCallbacks.CanMerge(prev, mNodes[idx].Value))
+                {
+                    prev.LastAddr = mNodes[idx].Value.LastAddr;
+                    UpdateLastAccess(prevIdx, accessTime);
+                    RemoveEntry(idx);
+                }
+            }
+        }
+
+        // Removes old entry
+        while (mSize > mCapacity)
+        {
+            RemoveEntry(mOldest);
+        }
+    }
+
+    Entry* Get(ADDR addr)
+    {
+        int idx = FindEntryByAddr(addr);
+        if (idx != NIL) return &mNodes[idx].Value;
+        return NULL;
+    }
+
+    // Visits the entries overlapping [firstAddr, lastAddr] in address order
+    // until the visitor returns false. The visitor is any object callable as
+    // bool (const GroupedHistoryEntry<T>&). Returns the number of entries
+    // visited.
+    template <typename Visitor>
+    int GetRange(ADDR firstAddr, ADDR lastAddr, Visitor& visitor)
+    {
+        int count = 0;
+        int idx = FindEntryByAddr(firstAddr);
+        if (idx == NIL) idx = FindNext(firstAddr);
+
+        while (idx != NIL && mNodes[idx].Value.FirstAddr <= lastAddr)
+        {
+            ++count;
+
+            const Entry& entry = mNodes[idx].Value;
+            if (!visitor(entry)) break;
+
+            idx = FindNext(entry.FirstAddr);
+        }
+
+        return count;
+    }
+
+    int Size() const { return mSize; }
+    int Capacity() const { return mCapacity; }
+
+    // Logs the entries in address order, one line each
+    void Print()
+    {
+        LOGD("History");
+        PrintTree(mRoot);
+    }
+
+private:
+    int AddNewEntry(ADDR firstAddr, ADDR lastAddr, TICK lastAccess,
+                    const T& data, int timeHint)
+    {
+        if (firstAddr > lastAddr) return NIL;
+
+        int found = FindFloor(firstAddr);
+        if (found != NIL && mNodes[found].Value.FirstAddr == firstAddr)
+        {
+            LOGE("Duplicate entry (firstAddr = 0x%016x)", firstAddr);
+            return NIL;
+        }
+
+        if (mFree == NIL)
+        {
+            LOGE("History full (firstAddr = 0x%016x)", firstAddr);
+            return NIL;
+        }
+
+        int idx = mFree;
+        Node& node = mNodes[idx];
+        mFree = node.Next;
+
+        node.Value.FirstAddr = firstAddr;
+        node.Value.LastAddr = lastAddr;
+        node.Value.LastAccess = lastAccess;
+        node.Value.Data = data;
+        node.Left = NIL;
+        node.Right = NIL;
+        node.Priority = NextPriority();
+
+        mRoot = TreeInsert(mRoot, idx);
+        LinkByTime(idx, timeHint);
+        ++mSize;
+
+        return idx;
+    }
+
+    void UpdateLastAccess(int idx, TICK lastAccess)
+    {
+        UnlinkByTime(idx);
+        mNodes[idx].Value.LastAccess = lastAccess;
+        LinkByTime(idx, NIL);
+    }
+
+    void RemoveEntry(int idx)
+    {
+        mRoot = TreeErase(mRoot, mNodes[idx].Value.FirstAddr);
+        UnlinkByTime(idx);
+
+        mNodes[idx].Next = mFree;
+        mFree = idx;
+        --mSize;
+    }
+
+    // ------------------------------------------------------ Address lookup
+    int FindEntryByAddr(ADDR addr)
+    {
+        int idx = FindFloor(addr);
+        if (idx != NIL && mNodes[idx].Value.LastAddr >= addr) return idx;
+        return NIL;
+    }
+
+    // Entry with the greatest FirstAddr <= addr
+    int FindFloor(ADDR addr)
+    {
+        int found = NIL;
+
+        for (int idx = mRoot; idx != NIL; )
+        {
+            if (mNodes[idx].Value.FirstAddr <= addr)
+            {
+                found = idx;
+                idx = mNodes[idx].Right;
+            }
+            else idx = mNodes[idx].Left;
+        }
+
+        return found;
+    }
+
+    // Entry with the greatest FirstAddr < addr
+    int FindPrev(ADDR addr)
+    {
+        return (addr > 0) ? FindFloor(addr - 1) : NIL;
+    }
+
+    // Entry with the smallest FirstAddr > addr
+    int FindNext(ADDR addr)
+    {
+        int found = NIL;
+
+        for (int idx = mRoot; idx != NIL; )
+        {
+            if (mNodes[idx].Value.FirstAddr > addr)
+            {
+                found = idx;
+                idx = mNodes[idx].Left;
+            }
+            else idx = mNodes[idx].Right;
+        }
+
+        return found;
+    }
+
+    // ----------------------------------------------------------- Treap
+    uint32_t NextPriority()
+    {
+        mSeed ^= mSeed << 13;
+        mSeed ^= mSeed >> 17;
+        mSeed ^= mSeed << 5;
+        return mSeed;
+    }
+
+    int RotateRight(int idx)
+    {
+        int left = mNodes[idx].Left;
+        mNodes[idx].Left = mNodes[left].Right;
+        mNodes[left].Right = idx;
+        return left;
+    }
+
+    int RotateLeft(int idx)
+    {
+        int right = mNodes[idx].Right;
+        mNodes[idx].Right = mNodes[right].Left;
+        mNodes[right].Left = idx;
+        return right;
+    }
+
+    int TreeInsert(int root, int idx)
+    {
+        if (root == NIL) return idx;
+
+        Node& node = mNodes[root];
+
+        if (mNodes[idx].Value.FirstAddr < node.Value.FirstAddr)
+        {
+            node.Left = TreeInsert(node.Left, idx);
+            if (mNodes[node.Left].Priority > node.Priority)
+                root = RotateRight(root);
+        }
+        else
+        {
+            node.Right = TreeInsert(node.Right, idx);
+            if (mNodes[node.Right].Priority > node.Priority)
+                root = RotateLeft(root);
+        }
+
+        return root;
+    }
+
+    int TreeErase(int root, ADDR firstAddr)
+    {
+        if (root == NIL) return NIL;
+
+        Node& node = mNodes[root];
+
+        if (firstAddr < node.Value.FirstAddr)
+            node.Left = TreeErase(node.Left, firstAddr);
+        else if (firstAddr > node.Value.FirstAddr)
+            node.Right = TreeErase(node.Right, firstAddr);
+        else
+        {
+            // Rotates the node down until it has at most one child
+            if (node.Left == NIL) return node.Right;
+            if (node.Right == NIL) return node.Left;
+
+            if (mNodes[node.Left].Priority > mNodes[node.Right].Priority)
+            {
+                root = RotateRight(root);
+                mNodes[root].Right = TreeErase(mNodes[root].Right, firstAddr);
+            }
+            else
+            {
+                root = RotateLeft(root);
+                mNodes[root].Left = TreeErase(mNodes[root].Left, firstAddr);
+            }
+        }
+
+        return root;
+    }
+
+    void PrintTree(int idx)
+    {
+        if (idx == NIL) return;
+
+        PrintTree(mNodes[idx].Left);
+
+        Entry* entry = &mNodes[idx].Value;
+        LOGD("[0x%016llx, 0x%016llx] lastAccess = %lld, data = %lld",
+             (unsigned long long)entry->FirstAddr,
+             (unsigned long long)entry->LastAddr,
+             (long long)entry->LastAccess, (long long)entry->Data);
+
+        PrintTree(mNodes[idx].Right);
+    }
+
+    // ------------------------------------------------- Time ordered list
+    // Inserts the entry after all the entries accessed at the same time or
+    // before. The search starts from the hint entry if any, from the newest
+    // entry otherwise; both are O(1) for accesses in time order.
+    void LinkByTime(int idx, int hint)
+    {
+        TICK lastAccess = mNodes[idx].Value.LastAccess;
+        int prev;
+
+        if (hint != NIL && mNodes[hint].Value.LastAccess <= lastAccess)
+        {
+            prev = hint;
+            while (mNodes[prev].Next != NIL &&
+                   mNodes[mNodes[prev].Next].Value.LastAccess <= lastAccess)
+                prev = mNodes[prev].Next;
+        }
+        else
+        {
+            prev = mNewest;
+            while (prev != NIL && mNodes[prev].Value.LastAccess > lastAccess)
+                prev = mNodes[prev].Prev;
+        }
+
+        int next = (prev != NIL) ? mNodes[prev].Next : mOldest;
+
+        mNodes[idx].Prev = prev;
+        mNodes[idx].Next = next;
+
+        if (prev != NIL) mNodes[prev].Next = idx; else mOldest = idx;
+        if (next != NIL) mNodes[next].Prev = idx; else mNewest = idx;
+    }
+
+    void UnlinkByTime(int idx)
+    {
+        int prev = mNodes[idx].Prev;
+        int next = mNodes[idx].Next;
+
+        if (prev != NIL) mNodes[prev].Next = next; else mOldest = next;
+        if (next != NIL) mNodes[next].Prev = prev; else mNewest = prev;
+    }
+};
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#pragma once
+
+#include <cstring>
+#include <stdint.h>
+
+/* PCs followed, must be a power of two */
+#ifndef LAST_MISS_TABLE_SIZE
+#  define LAST_MISS_TABLE_SIZE 256
+#endif /* LAST_MISS_TABLE_SIZE */
+
+/**
+ * Last block missed by every PC, so that the misses of each PC form their
+ * own stream. Consecutive misses of a PC are usually near each other even
+ * when the global miss stream jumps between distant regions.
+ *
+ * This is what the compact tables (MARKOV_COMPACT, GROUPED_HISTORY_COMPACT)
+ * are built on: they store blocks on 32 bits, which cover every block
+ * below MAX_PHYS_MEM_ADDR, and the step from a miss to the next miss of the
+ * same PC as a 16-bit delta in blocks. A step whose delta does not fit is
+ * not recorded.
+ *
+ * Direct-mapped with 32-bit blocks numbers and a partial PC tag.
+ */
+class LastMissTable
+{
+private:
+    struct Entry
+    {
+        uint32_t Tag;
+        uint32_t Block; /* Block number, 0 if none */
+    };
+
+    Entry mEntries[LAST_MISS_TABLE_SIZE];
+
+public:
+    void Init()
+    {
+        memset(mEntries, 0, sizeof(mEntries));
+    }
+
+    /* Records the miss and returns the previous block missed by the PC, 0
+       if none */
+    Addr Swap(Addr pc, Addr block)
+    {
+        Addr index = pc >> 2;
+        Entry& entry = mEntries[index & (LAST_MISS_TABLE_SIZE - 1)];
+        uint32_t tag = (uint32_t)(index / LAST_MISS_TABLE_SIZE);
+
+        Addr last = (entry.Tag == tag) ? (Addr)entry.Block * BLOCK_SIZE : 0;
+
+        entry.Tag = tag;
+        entry.Block = (uint32_t)(block / BLOCK_SIZE);
+
+        return last;
+    }
+};
@@ -0,0 +1,206 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+
+#include "prefetch_feedback.hh"
+#include "prefetch_filter.hh"
+
+/* Candidates held while the prefetch queue is full */
+#ifndef PENDING_SIZE
+#  define PENDING_SIZE 32
+#endif /* PENDING_SIZE */
+
+/* Cycles after which a held candidate is too late to be worth issuing */
+#ifndef PENDING_MAX_AGE
+#  define PENDING_MAX_AGE 256
+#endif /* PENDING_MAX_AGE */
+
+/**
+ * Prefetches waiting for a slot in the prefetch queue.
+ *
+ * The prefetchers push their candidates with a priority instead of issuing
+ * them, with the PC of the access which triggered them. Drain() issues the
+ * held candidates, the highest priority and then the newest first, as long
+ * as the prefetch queue has room, and tells the observer about every one;
+ * it is called at the end of every access and on every completed prefetch,
+ * which frees a slot. Candidates which wait too long, or whose block is
+ * accessed by the program in the meantime, are dropped. When all the
+ * entries are taken, a new candidate replaces the one with the lowest
+ * priority, the oldest on a tie, or is rejected if it has no higher
+ * priority.
+ */
+template <class Filter = PrefetchFilter, class Throttle = FeedbackController>
+class PendingPrefetchQueue
+{
+private:
+    struct Entry
+    {
+        Addr Block;
+        Addr Pc;
+        int Priority;
+        int64_t Time;
+        bool Valid;
+    };
+
+    Entry mEntries[PENDING_SIZE];
+    int mCount;
+    int64_t mNow;
+
+    Filter& mFilter;
+    Throttle& mThrottle;
+
+    uint64_t mIssued;
+    uint64_t mDeferred;
+    uint64_t mAged;
+    uint64_t mDemanded;
+    uint64_t mReplaced;
+    uint64_t mRejected;
+
+public:
+    PendingPrefetchQueue(Filter& filter, Throttle& throttle)
+        : mFilter(filter), mThrottle(throttle)
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        for (int i = 0; i < PENDING_SIZE; ++i)
+            mEntries[i].Valid = false;
+
+        mCount = 0;
+        mNow = 0;
+        mIssued = mDeferred = mAged = mDemanded = mReplaced = mRejected = 0;
+    }
+
+    int Size() const { return mCount; }
+
+    /* Called on every demand access, before the new candidates are pushed */
+    void Access(Addr addr, int64_t time)
+    {
+        mNow = time;
+
+        for (int i = 0; i < PENDING_SIZE; ++i)
+        {
+            Entry& entry = mEntries[i];
+
+            if (entry.Valid && entry.Block == addr)
+            {
+                ++mDemanded;
+                Drop(entry);
+            }
+        }
+    }
+
+    /* Returns false if the candidate is filtered out or not worth holding */
+    bool Push(Addr addr, int priority, Addr pc)
+    {
+        if (!mFilter.Allow(addr)) return false;
+
+        Entry* slot = NULL;
+        Entry* lowest = NULL;
+
+        for (int i = 0; i < PENDING_SIZE; ++i)
+        {
+            Entry& entry = mEntries[i];
+
+            if (!entry.Valid) { slot = &entry; break; }
+
+            if (lowest == NULL || entry.Priority < lowest->Priority ||
+                (entry.Priority == lowest->Priority && entry.Time < lowest->Time))
+                lowest = &entry;
+        }
+
+        if (slot == NULL)
+        {
+            if (lowest->Priority >= priority)
+            {
+                /* Not worth more than anything already held */
+                ++mRejected;
+                mFilter.Complete(addr);
+                return false;
+            }
+
+            ++mReplaced;
+            Drop(*lowest);
+            slot = lowest;
+        }
+
+        slot->Block = addr;
+        slot->Pc = pc;
+        slot->Priority = priority;
+        slot->Time = mNow;
+        slot->Valid = true;
+        ++mCount;
+
+        if (current_queue_size() >= MAX_QUEUE_SIZE) ++mDeferred;
+        return true;
+    }
+
+    template <class Observer>
+    void Drain(Observer& observer)
+    {
+        while (mCount > 0 && current_queue_size() < MAX_QUEUE_SIZE)
+        {
+            Entry* best = NULL;
+
+            for (int i = 0; i < PENDING_SIZE; ++i)
+            {
+                Entry& entry = mEntries[i];
+                if (!entry.Valid) continue;
+
+                if (mNow - entry.Time > PENDING_MAX_AGE)
+                {
+                    ++mAged;
+                    Drop(entry);
+                    continue;
+                }
+
+                if (best == NULL || entry.Priority > best->Priority ||
+                    (entry.Priority == best->Priority && entry.Time > best->Time))
+                    best = &entry;
+            }
+
+            if (best == NULL) break;
+
+            best->Valid = false;
+            --mCount;
+
+            issue_prefetch(best->Block);
+            mThrottle.Issue();
+            observer.Issued(best->Block, best->Pc);
+            ++mIssued;
+        }
+    }
+
+    void Print(FILE* file, const char* name) const
+    {
+        fprintf(file, "%s: pending issued = %llu, deferred = %llu, "
+                "dropped aged = %llu, demanded = %llu, replaced = %llu, "
+                "rejected = %llu\n",
+                name, (unsigned long long)mIssued,
+                (unsigned long long)mDeferred, (unsigned long long)mAged,
+                (unsigned long long)mDemanded,
+                (unsigned long long)mReplaced,
+                (unsigned long long)mRejected);
+    }
+
+private:
+    /* Forgets a held candidate, so the filter lets it through again */
+    void Drop(Entry& entry)
+    {
+        mFilter.Complete(entry.Block);
+        entry.Valid = false;
+        --mCount;
+    }
+};
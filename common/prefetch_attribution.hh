@@ -0,0 +1,271 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Per-PC attribution of the prefetches, compiled in with
+ * -DPREFETCH_ATTRIBUTION. Every issued prefetch is tagged with the PC of
+ * the access which triggered it and the throttle level it was issued at,
+ * and followed until it is decided:
+ *
+ *   useful     the first demand hit finds its prefetch bit set
+ *   late       a demand miss finds it still in the MSHR queue (also
+ *              useful)
+ *   evicted    a demand miss finds it neither in flight nor cached, or it
+ *              is no longer cached when its tracking slot is needed or at
+ *              the end of the run
+ *
+ * Useful, late and evicted prefetches are charged to the PC which
+ * triggered them, which is not the PC of the demand for the predictors
+ * which correlate across PCs. The coverage of a PC is that of its own
+ * demands: those which a prefetch served, on time or late, against its
+ * demand misses. Only the cache functions of the interface are used, so
+ * the report works in M5 as well.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+/* PCs reported, must be a power of two. The PCs which do not fit are
+   counted together as "other". */
+#ifndef ATTRIBUTION_PCS
+#  define ATTRIBUTION_PCS 1024
+#endif /* ATTRIBUTION_PCS */
+
+/* Prefetches followed at once, must be a power of two */
+#ifndef ATTRIBUTION_TRACKED
+#  define ATTRIBUTION_TRACKED 4096
+#endif /* ATTRIBUTION_TRACKED */
+
+/* Rows of the report, the PCs with the most prefetches and demands served
+   or missed first */
+#ifndef ATTRIBUTION_ROWS
+#  define ATTRIBUTION_ROWS 32
+#endif /* ATTRIBUTION_ROWS */
+
+class PrefetchAttribution
+{
+private:
+    enum { OTHER = ATTRIBUTION_PCS, NONE = -1 };
+
+    struct Row
+    {
+        Addr Pc;
+        uint64_t Issued;
+        uint64_t Useful;
+        uint64_t Late;
+        uint64_t Evicted;
+        uint64_t Misses;  /* Demand misses not covered by any prefetch */
+        uint64_t Covered; /* Demands served by a prefetch */
+        uint64_t Levels;  /* Sum of the throttle levels at issue */
+        bool Valid;
+    };
+
+    struct Tracked
+    {
+        Addr Block;
+        int Row;     /* NONE if the slot is free */
+        bool Landed; /* Completed, waiting for its first demand access */
+    };
+
+    Row mRows[ATTRIBUTION_PCS + 1]; /* The last one is "other" */
+    Tracked mTracked[ATTRIBUTION_TRACKED];
+
+    /* Prefetches whose slot was needed before they were decided */
+    uint64_t mUntracked;
+
+public:
+    void Reset()
+    {
+        memset(mRows, 0, sizeof(mRows));
+        mUntracked = 0;
+
+        for (int i = 0; i < ATTRIBUTION_TRACKED; ++i)
+            mTracked[i].Row = NONE;
+    }
+
+    /* Called on every demand access, before the prefetch bit is cleared */
+    void Access(Addr block, Addr pc, int miss)
+    {
+        Tracked& slot = GetTracked(block);
+
+        if (slot.Row == NONE || slot.Block != block)
+        {
+            if (miss) ++mRows[GetRow(pc)].Misses;
+            return;
+        }
+
+        Row& row = mRows[slot.Row];
+
+        if (!slot.Landed)
+        {
+            /* Issued, but the cache may have dropped it */
+            if (miss && in_mshr_queue(block))
+            {
+                ++row.Useful;
+                ++row.Late;
+                ++mRows[GetRow(pc)].Covered;
+            }
+            else ++mUntracked;
+        }
+        else if (!miss)
+        {
+            if (get_prefetch_bit(block))
+            {
+                ++row.Useful;
+                ++mRows[GetRow(pc)].Covered;
+            }
+        }
+        else
+        {
+            ++row.Evicted;
+            ++mRows[GetRow(pc)].Misses;
+        }
+
+        slot.Row = NONE;
+    }
+
+    void Issue(Addr block, Addr pc, int level)
+    {
+        Tracked& slot = GetTracked(block);
+        if (slot.Row != NONE) Forget(slot);
+
+        int row = GetRow(pc);
+        ++mRows[row].Issued;
+        mRows[row].Levels += level;
+
+        slot.Block = block;
+        slot.Row = row;
+        slot.Landed = false;
+    }
+
+    void Complete(Addr block)
+    {
+        Tracked& slot = GetTracked(block);
+        if (slot.Row != NONE && slot.Block == block) slot.Landed = true;
+    }
+
+    void Print(FILE* file, const char* name) const
+    {
+        Row rows[ATTRIBUTION_PCS + 1];
+        memcpy(rows, mRows, sizeof(rows));
+
+        /* The prefetches still followed, those no longer cached were
+           evicted unused, the others are left out */
+        for (int i = 0; i < ATTRIBUTION_TRACKED; ++i)
+        {
+            const Tracked& slot = mTracked[i];
+            if (slot.Row != NONE && slot.Landed && !in_cache(slot.Block))
+                ++rows[slot.Row].Evicted;
+        }
+
+        int order[ATTRIBUTION_PCS + 1];
+        int count = 0;
+
+        for (int i = 0; i <= ATTRIBUTION_PCS; ++i)
+            if (rows[i].Valid || rows[i].Issued > 0 || rows[i].Misses > 0)
+                order[count++] = i;
+
+        std::sort(order, order + count, ByWeight(rows));
+
+        fprintf(file, "%s: %-18s %9s %9s %9s %9s %9s %4s %4s %5s\n", name,
+                "PC", "ISSUED", "USEFUL", "LATE", "EVICTED", "MISSES",
+                "ACC", "COV", "LEVEL");
+
+        for (int i = 0; i < count && i < ATTRIBUTION_ROWS; ++i)
+        {
+            const Row& row = rows[order[i]];
+
+            char pc[19];
+            if (order[i] == OTHER) snprintf(pc, sizeof(pc), "other");
+            else snprintf(pc, sizeof(pc), "0x%016llx",
+                          (unsigned long long)row.Pc);
+
+            double acc = (row.Issued > 0)
+                ? (double)row.Useful / row.Issued : 0.0;
+            double cov = (row.Covered + row.Misses > 0)
+                ? (double)row.Covered / (row.Covered + row.Misses) : 0.0;
+            double level = (row.Issued > 0)
+                ? (double)row.Levels / row.Issued : 0.0;
+
+            fprintf(file, "%s: %-18s %9llu %9llu %9llu %9llu %9llu "
+                    "%4.2f %4.2f %5.2f\n",
+                    name, pc, (unsigned long long)row.Issued,
+                    (unsigned long long)row.Useful,
+                    (unsigned long long)row.Late,
+                    (unsigned long long)row.Evicted,
+                    (unsigned long long)row.Misses, acc, cov, level);
+        }
+
+        fprintf(file, "%s: %d PCs, %llu prefetches not followed to the end\n",
+                name, count, (unsigned long long)mUntracked);
+    }
+
+private:
+    class ByWeight
+    {
+    private:
+        const Row* mRows;
+
+    public:
+        ByWeight(const Row* rows) : mRows(rows) { }
+
+        bool operator()(int a, int b) const
+        {
+            uint64_t wa = Weight(mRows[a]);
+            uint64_t wb = Weight(mRows[b]);
+            return (wa != wb) ? wa > wb : a < b;
+        }
+
+        static uint64_t Weight(const Row& row)
+        {
+            return row.Issued + row.Covered + row.Misses;
+        }
+    };
+
+    Tracked& GetTracked(Addr block)
+    {
+        uint64_t hash = (block / BLOCK_SIZE) * 0x9e3779b97f4a7c15ULL;
+        return mTracked[(hash >> 40) & (ATTRIBUTION_TRACKED - 1)];
+    }
+
+    /* Row of the PC, by linear probing, "other" once the table is full */
+    int GetRow(Addr pc)
+    {
+        uint64_t hash = (pc >> 2) * 0x9e3779b97f4a7c15ULL;
+        int start = (hash >> 40) & (ATTRIBUTION_PCS - 1);
+
+        for (int i = 0; i < ATTRIBUTION_PCS; ++i)
+        {
+            int index = (start + i) & (ATTRIBUTION_PCS - 1);
+            Row& row = mRows[index];
+
+            if (row.Valid && row.Pc == pc) return index;
+
+            if (!row.Valid)
+            {
+                row.Pc = pc;
+                row.Valid = true;
+                return index;
+            }
+        }
+
+        return OTHER;
+    }
+
+    /* The slot is needed by another prefetch before this one was decided */
+    void Forget(Tracked& slot)
+    {
+        if (slot.Landed && !in_cache(slot.Block)) ++mRows[slot.Row].Evicted;
+        else ++mUntracked;
+
+        slot.Row = NONE;
+    }
+};
@@ -0,0 +1,258 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   Santhosh Srinath, Onur Mutlu, Hyesoon Kim, Yale N. Patt, "Feedback
+ *     Directed Prefetching: Improving the Performance and Bandwidth-
+ *     Efficiency of Hardware Prefetchers", HPCA 2007
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+
+/* Aggressiveness levels, 0 turns prefetching off */
+#ifndef FEEDBACK_MAX_LEVEL
+#  define FEEDBACK_MAX_LEVEL 4
+#endif /* FEEDBACK_MAX_LEVEL */
+
+/* Demand misses per sampling interval */
+#ifndef FEEDBACK_INTERVAL
+#  define FEEDBACK_INTERVAL 4096
+#endif /* FEEDBACK_INTERVAL */
+
+/* Fewer prefetches than this in an interval are not worth a decision */
+#ifndef FEEDBACK_MIN_ISSUED
+#  define FEEDBACK_MIN_ISSUED 64
+#endif /* FEEDBACK_MIN_ISSUED */
+
+/* Intervals spent off before prefetching is tried again at level 1 */
+#ifndef FEEDBACK_PROBE
+#  define FEEDBACK_PROBE 8
+#endif /* FEEDBACK_PROBE */
+
+/* Thresholds, in percent */
+#ifndef FEEDBACK_ACC_HIGH
+#  define FEEDBACK_ACC_HIGH 75
+#endif /* FEEDBACK_ACC_HIGH */
+#ifndef FEEDBACK_ACC_LOW
+#  define FEEDBACK_ACC_LOW 40
+#endif /* FEEDBACK_ACC_LOW */
+#ifndef FEEDBACK_LATE
+#  define FEEDBACK_LATE 10
+#endif /* FEEDBACK_LATE */
+#ifndef FEEDBACK_POLLUTION
+#  define FEEDBACK_POLLUTION 25
+#endif /* FEEDBACK_POLLUTION */
+
+/* Late blocks remembered until they complete, a bit more than the prefetch
+   queue can hold */
+#ifndef FEEDBACK_LATE_BLOCKS
+#  define FEEDBACK_LATE_BLOCKS 128
+#endif /* FEEDBACK_LATE_BLOCKS */
+
+/**
+ * Feedback-directed throttling shared by the prefetchers.
+ *
+ * The prefetcher reports every demand access, every issued prefetch and
+ * every completed prefetch. Completed prefetches get their prefetch bit
+ * set; the first demand hit on such a block counts as a useful prefetch
+ * and clears the bit, and a demand miss on a block still in the MSHR queue
+ * counts as a late one. A late block has already been counted, so it does
+ * not get the bit when it completes. At the end of each interval of
+ * FEEDBACK_INTERVAL demand misses, the accuracy, the lateness and the
+ * pollution (completed prefetches never referenced, per demand miss) of
+ * the interval move the aggressiveness level up or down. The prefetcher
+ * scales its own degree or distance with Scale().
+ */
+class FeedbackController
+{
+private:
+    int mLevel;
+    int mOffIntervals;
+
+    /* Current interval */
+    uint64_t mMisses;
+    uint64_t mIssued;
+    uint64_t mCompleted;
+    uint64_t mUseful;
+    uint64_t mLate;
+
+    /* Whole run */
+    uint64_t mTotalIssued;
+    uint64_t mTotalUseful;
+    uint64_t mTotalLate;
+    uint64_t mIntervals;
+    uint64_t mLevelIntervals[FEEDBACK_MAX_LEVEL + 1];
+
+    Addr mLateBlocks[FEEDBACK_LATE_BLOCKS]; /* 0 if the entry is free */
+    int mNextLate;                          /* FIFO replacement */
+
+public:
+    FeedbackController(int startLevel = FEEDBACK_MAX_LEVEL)
+    {
+        Reset(startLevel);
+    }
+
+    void Reset(int startLevel = FEEDBACK_MAX_LEVEL)
+    {
+        mLevel = startLevel;
+        mOffIntervals = 0;
+
+        mMisses = mIssued = mCompleted = mUseful = mLate = 0;
+        mTotalIssued = mTotalUseful = mTotalLate = mIntervals = 0;
+
+        for (int i = 0; i <= FEEDBACK_MAX_LEVEL; ++i)
+            mLevelIntervals[i] = 0;
+
+        for (int i = 0; i < FEEDBACK_LATE_BLOCKS; ++i)
+            mLateBlocks[i] = 0;
+
+        mNextLate = 0;
+    }
+
+    int Level() const { return mLevel; }
+    bool Enabled() const { return mLevel > 0; }
+
+    /* Scales a maximum degree or distance to the current level */
+    int Scale(int max) const
+    {
+        if (mLevel == 0) return 0;
+
+        int value = (max * mLevel + FEEDBACK_MAX_LEVEL - 1) / FEEDBACK_MAX_LEVEL;
+        return (value > 0) ? value : 1;
+    }
+
+    /* Returns 1 if the access is the first demand hit on a prefetched block */
+    int Access(Addr addr, int miss)
+    {
+        int useful = 0;
+
+        if (!miss)
+        {
+            if (get_prefetch_bit(addr))
+            {
+                clear_prefetch_bit(addr);
+                ++mUseful;
+                ++mTotalUseful;
+                useful = 1;
+            }
+        }
+        else
+        {
+            /* Once per in-flight block */
+            if (in_mshr_queue(addr) && FindLate(addr) < 0)
+            {
+                mLateBlocks[mNextLate] = addr;
+                mNextLate = (mNextLate + 1) % FEEDBACK_LATE_BLOCKS;
+
+                ++mUseful;
+                ++mLate;
+                ++mTotalUseful;
+                ++mTotalLate;
+            }
+
+            if (++mMisses >= FEEDBACK_INTERVAL) EndInterval();
+        }
+
+        return useful;
+    }
+
+    void Issue()
+    {
+        ++mIssued;
+        ++mTotalIssued;
+    }
+
+    void Complete(Addr addr)
+    {
+        int i = FindLate(addr);
+
+        if (i >= 0) mLateBlocks[i] = 0;
+        else set_prefetch_bit(addr);
+
+        ++mCompleted;
+    }
+
+    uint64_t TotalUseful() const { return mTotalUseful; }
+    uint64_t TotalLate() const { return mTotalLate; }
+
+    void Print(FILE* file, const char* name) const
+    {
+        fprintf(file, "%s: feedback level = %d, issued = %llu, useful = %llu, "
+                "late = %llu, intervals per level =",
+                name, mLevel, (unsigned long long)mTotalIssued,
+                (unsigned long long)mTotalUseful,
+                (unsigned long long)mTotalLate);
+
+        for (int i = 0; i <= FEEDBACK_MAX_LEVEL; ++i)
+            fprintf(file, " %llu", (unsigned long long)mLevelIntervals[i]);
+
+        fprintf(file, "\n");
+    }
+
+private:
+    int FindLate(Addr addr) const
+    {
+        for (int i = 0; i < FEEDBACK_LATE_BLOCKS; ++i)
+            if (mLateBlocks[i] == addr) return i;
+
+        return -1;
+    }
+
+    void EndInterval()
+    {
+        ++mIntervals;
+        ++mLevelIntervals[mLevel];
+
+        if (mLevel == 0)
+        {
+            /* Nothing to measure while off, probes again from time to time */
+            if (++mOffIntervals >= FEEDBACK_PROBE)
+            {
+                mOffIntervals = 0;
+                mLevel = 1;
+            }
+        }
+        else if (mIssued >= FEEDBACK_MIN_ISSUED)
+        {
+            uint64_t useless = (mCompleted > mUseful) ? mCompleted - mUseful : 0;
+
+            int accuracy = (int)(100 * mUseful / mIssued);
+            int lateness = (mUseful > 0) ? (int)(100 * mLate / mUseful) : 0;
+            int pollution = (int)(100 * useless / mMisses);
+
+            bool late = (lateness > FEEDBACK_LATE);
+            bool polluting = (pollution > FEEDBACK_POLLUTION);
+
+            if (accuracy >= FEEDBACK_ACC_HIGH)
+            {
+                if (late) Up();
+            }
+            else if (accuracy >= FEEDBACK_ACC_LOW)
+            {
+                if (polluting) Down();
+                else if (late) Up();
+            }
+            else Down();
+        }
+
+        mMisses = mIssued = mCompleted = mUseful = mLate = 0;
+    }
+
+    void Up()
+    {
+        if (mLevel < FEEDBACK_MAX_LEVEL) ++mLevel;
+    }
+
+    void Down()
+    {
+        if (mLevel > 0) --mLevel;
+    }
+};
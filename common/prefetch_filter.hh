@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+
+/* Blocks remembered between their issue and their completion, a bit more
+   than the prefetch queue can hold */
+#ifndef FILTER_SIZE
+#  define FILTER_SIZE 128
+#endif /* FILTER_SIZE */
+
+/**
+ * Filter of the prefetch candidates, shared by the prefetchers.
+ *
+ * A block waiting in the prefetch queue is neither in the cache nor in the
+ * MSHR queue yet, so without the filter a prefetcher would issue it again
+ * on every access until it completes. Issued blocks are kept in a small
+ * fully-associative tag buffer until prefetch_complete, or until they are
+ * the oldest entry when a new one is needed.
+ */
+class PrefetchFilter
+{
+private:
+    Addr mTags[FILTER_SIZE]; /* 0 if the entry is free */
+    int mNext;               /* FIFO replacement */
+
+    uint64_t mAllowed;
+    uint64_t mInCache;
+    uint64_t mDuplicates;
+
+public:
+    PrefetchFilter()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        for (int i = 0; i < FILTER_SIZE; ++i)
+            mTags[i] = 0;
+
+        mNext = 0;
+        mAllowed = mInCache = mDuplicates = 0;
+    }
+
+    /* Returns true if the block is worth prefetching, in which case it is
+       assumed to be issued right away */
+    bool Allow(Addr addr)
+    {
+        if (in_cache(addr))
+        {
+            ++mInCache;
+            return false;
+        }
+
+        if (Find(addr) >= 0 || in_mshr_queue(addr))
+        {
+            ++mDuplicates;
+            return false;
+        }
+
+        mTags[mNext] = addr;
+        mNext = (mNext + 1) % FILTER_SIZE;
+
+        ++mAllowed;
+        return true;
+    }
+
+    void Complete(Addr addr)
+    {
+        int i = Find(addr);
+        if (i >= 0) mTags[i] = 0;
+    }
+
+    uint64_t Duplicates() const { return mDuplicates; }
+
+    void Print(FILE* file, const char* name) const
+    {
+        fprintf(file, "%s: filter allowed = %llu, in cache = %llu, "
+                "duplicates suppressed = %llu\n",
+                name, (unsigned long long)mAllowed,
+                (unsigned long long)mInCache,
+                (unsigned long long)mDuplicates);
+    }
+
+private:
+    int Find(Addr addr) const
+    {
+        for (int i = 0; i < FILTER_SIZE; ++i)
+            if (mTags[i] == addr) return i;
+
+        return -1;
+    }
+};
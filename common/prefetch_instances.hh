@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * The prefetcher instances of a variant. All the state of a prefetcher
+ * lives in its pipeline object, and the prefetch_* functions are adapters
+ * which forward to the instance selected by the calling thread: the default
+ * one unless prefetch_select chose another. M5 only ever uses the default
+ * instance; the simulator creates one per modelled cache, so that several
+ * of them can run side by side, in one thread or in several.
+ *
+ * Logging is shared by all the instances and is not thread-safe.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+template <class Prefetcher>
+class PrefetcherInstances
+{
+private:
+    int mStartLevel;
+    Prefetcher mDefault;
+
+    static __thread Prefetcher* sCurrent; /* NULL for the default instance */
+
+public:
+    PrefetcherInstances(int startLevel = FEEDBACK_MAX_LEVEL)
+        : mStartLevel(startLevel), mDefault(startLevel)
+    { }
+
+    Prefetcher& Current()
+    {
+        return (sCurrent != NULL) ? *sCurrent : mDefault;
+    }
+
+    /* Instances are opaque to the simulator */
+    void* Create()
+    {
+        return new Prefetcher(mStartLevel);
+    }
+
+    void Destroy(void* instance)
+    {
+        if (sCurrent == instance) sCurrent = NULL;
+        delete static_cast<Prefetcher*>(instance);
+    }
+
+    void Select(void* instance)
+    {
+        sCurrent = static_cast<Prefetcher*>(instance);
+    }
+};
+
+template <class Prefetcher>
+__thread Prefetcher* PrefetcherInstances<Prefetcher>::sCurrent = NULL;
+
+/* Defines the optional instance functions of the interface on top of the
+   PrefetcherInstances object of the variant */
+#define PREFETCH_INSTANCE_FUNCTIONS(instances)                              \
+    void* prefetch_create(void)                                             \
+    {                                                                       \
+        return instances.Create();                                          \
+    }                                                                       \
+                                                                            \
+    void prefetch_destroy(void* instance)                                   \
+    {                                                                       \
+        instances.Destroy(instance);                                        \
+    }                                                                       \
+                                                                            \
+    void prefetch_select(void* instance)                                    \
+    {                                                                       \
+        instances.Select(instance);                                         \
+    }
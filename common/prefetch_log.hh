@@ -0,0 +1,295 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Logging shared by all the prefetchers.
+ *
+ * LOG_LEVEL selects at compile time which of LOGE, LOGI and LOGD are
+ * compiled in; the disabled ones expand to nothing and do not even
+ * evaluate their arguments. By default only errors are logged, build with
+ * -DLOG_LEVEL=LOG_LEVEL_DEBUG to get the debug trace through DPRINTF.
+ *
+ * With -DLOG_EVENTS, the enabled log calls do not format anything: they
+ * append a binary event (time, call site, format, raw arguments) to a
+ * lock-free ring buffer, which is only formatted by LOG_EVENT_DUMP().
+ * LOG_SET_TIME() sets the time stamp of the following events. The
+ * arguments are kept as 64-bit integers and passed back with the type of
+ * their conversion, so only integer conversions and %p are supported; a
+ * string argument does not compile, as only its pointer would be kept.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_DEBUG 3
+
+#ifndef LOG_LEVEL
+#  define LOG_LEVEL LOG_LEVEL_ERROR
+#endif /* LOG_LEVEL */
+
+/* ----------------------------------------------------------- Text output */
+static inline void PrintLog(const char* func, const char* tag,
+                            const char* format, ...)
+{
+    static char buffer[1000];
+
+    int len = snprintf(buffer, sizeof(buffer), "%s ", tag);
+
+    va_list args;
+    va_start(args, format);
+    len += vsnprintf(&buffer[len], sizeof(buffer) - len, format, args);
+    va_end(args);
+
+    if (len < (int)sizeof(buffer))
+        snprintf(&buffer[len], sizeof(buffer) - len, " (%s)\n", func);
+
+    DPRINTF(HWPrefetch, "%s", buffer);
+}
+
+/* ---------------------------------------------------------- Event buffer */
+#ifdef LOG_EVENTS
+
+#ifndef LOG_EVENT_RING_SIZE
+#  define LOG_EVENT_RING_SIZE 65536 /* Must be a power of two */
+#endif /* LOG_EVENT_RING_SIZE */
+
+#define LOG_EVENT_MAX_ARGS 5
+
+struct LogEvent
+{
+    int64_t Time;
+    const char* Func;
+    const char* Tag;
+    const char* Format; /* Identifies the event */
+    int NumArgs;
+    uint64_t Args[LOG_EVENT_MAX_ARGS];
+};
+
+static LogEvent log_events[LOG_EVENT_RING_SIZE];
+static uint64_t log_event_count;
+static int64_t log_event_time;
+
+/* Returned for a string argument, which then fails to compile */
+struct StringArgumentNotSupported { };
+
+template <typename T>
+static inline uint64_t LogEventArg(T value)
+{
+    return (uint64_t)value;
+}
+
+static inline StringArgumentNotSupported LogEventArg(const char* value)
+{
+    return StringArgumentNotSupported();
+}
+
+static inline StringArgumentNotSupported LogEventArg(char* value)
+{
+    return StringArgumentNotSupported();
+}
+
+/* Reserves a slot, several threads may log at the same time */
+static inline LogEvent& LogEventSlot(const char* func, const char* tag,
+                                     const char* format, int numArgs)
+{
+    uint64_t index = __sync_fetch_and_add(&log_event_count, 1);
+    LogEvent& event = log_events[index & (LOG_EVENT_RING_SIZE - 1)];
+
+    event.Time = log_event_time;
+    event.Func = func;
+    event.Tag = tag;
+    event.Format = format;
+    event.NumArgs = numArgs;
+    return event;
+}
+
+static inline void LogEventRecord(const char* func, const char* tag,
+                                  const char* format)
+{
+    LogEventSlot(func, tag, format, 0);
+}
+
+template <typename A>
+static inline void LogEventRecord(const char* func, const char* tag,
+                                  const char* format, A a)
+{
+    LogEvent& event = LogEventSlot(func, tag, format, 1);
+    event.Args[0] = LogEventArg(a);
+}
+
+template <typename A, typename B>
+static inline void LogEventRecord(const char* func, const char* tag,
+                                  const char* format, A a, B b)
+{
+    LogEvent& event = LogEventSlot(func, tag, format, 2);
+    event.Args[0] = LogEventArg(a);
+    event.Args[1] = LogEventArg(b);
+}
+
+template <typename A, typename B, typename C>
+static inline void LogEventRecord(const char* func, const char* tag,
+                                  const char* format, A a, B b, C c)
+{
+    LogEvent& event = LogEventSlot(func, tag, format, 3);
+    event.Args[0] = LogEventArg(a);
+    event.Args[1] = LogEventArg(b);
+    event.Args[2] = LogEventArg(c);
+}
+
+template <typename A, typename B, typename C, typename D>
+static inline void LogEventRecord(const char* func, const char* tag,
+                                  const char* format, A a, B b, C c, D d)
+{
+    LogEvent& event = LogEventSlot(func, tag, format, 4);
+    event.Args[0] = LogEventArg(a);
+    event.Args[1] = LogEventArg(b);
+    event.Args[2] = LogEventArg(c);
+    event.Args[3] = LogEventArg(d);
+}
+
+template <typename A, typename B, typename C, typename D, typename E>
+static inline void LogEventRecord(const char* func, const char* tag,
+                                  const char* format, A a, B b, C c, D d, E e)
+{
+    LogEvent& event = LogEventSlot(func, tag, format, 5);
+    event.Args[0] = LogEventArg(a);
+    event.Args[1] = LogEventArg(b);
+    event.Args[2] = LogEventArg(c);
+    event.Args[3] = LogEventArg(d);
+    event.Args[4] = LogEventArg(e);
+}
+
+/* Formats the next conversion of the format with the argument, cast back
+   to the type the conversion expects. Returns the end of the conversion. */
+static inline const char* LogEventConvert(FILE* file, const char* format,
+                                          uint64_t arg)
+{
+    char spec[32];
+    int len = 0;
+
+    /* Flags, width and precision */
+    spec[len++] = *format++;
+    while (*format != '\0' && strchr("-+ #0123456789.", *format) &&
+           len < 16)
+        spec[len++] = *format++;
+
+    /* Length modifier, 0 for int, 1 for long, 2 for long long */
+    int size = 0;
+    for (; *format != '\0' && strchr("hlLqjzt", *format); ++format)
+    {
+        if (*format == 'l') ++size;
+        else if (*format != 'h') size = 2;
+    }
+
+    for (int i = 0; i < size && i < 2; ++i) spec[len++] = 'l';
+
+    char conversion = *format;
+    if (conversion == '\0') return format;
+
+    spec[len++] = conversion;
+    spec[len] = '\0';
+
+    switch (conversion)
+    {
+    case 'd': case 'i':
+        if (size == 0) fprintf(file, spec, (int)arg);
+        else if (size == 1) fprintf(file, spec, (long)arg);
+        else fprintf(file, spec, (long long)arg);
+        break;
+
+    case 'u': case 'x': case 'X': case 'o': case 'c':
+        if (size == 0) fprintf(file, spec, (unsigned)arg);
+        else if (size == 1) fprintf(file, spec, (unsigned long)arg);
+        else fprintf(file, spec, (unsigned long long)arg);
+        break;
+
+    case 'p':
+        fprintf(file, spec, (void*)(uintptr_t)arg);
+        break;
+
+    default:
+        fprintf(file, "<%s?>", spec);
+        break;
+    }
+
+    return format + 1;
+}
+
+/* Formats the events still in the ring, oldest first */
+static inline void LogEventDump(FILE* file)
+{
+    uint64_t count = log_event_count;
+    uint64_t first = (count > LOG_EVENT_RING_SIZE)
+        ? count - LOG_EVENT_RING_SIZE : 0;
+
+    for (uint64_t i = first; i < count; ++i)
+    {
+        const LogEvent& event = log_events[i & (LOG_EVENT_RING_SIZE - 1)];
+        const char* format = event.Format;
+        int arg = 0;
+
+        fprintf(file, "%lld: %s ", (long long)event.Time, event.Tag);
+
+        while (*format != '\0')
+        {
+            if (format[0] != '%') fputc(*format++, file);
+            else if (format[1] == '%')
+            {
+                fputc('%', file);
+                format += 2;
+            }
+            else
+            {
+                uint64_t value = (arg < event.NumArgs) ? event.Args[arg] : 0;
+                ++arg;
+                format = LogEventConvert(file, format, value);
+            }
+        }
+
+        fprintf(file, " (%s)\n", event.Func);
+    }
+}
+
+#  define LOG_WRITE(tag, ...) LogEventRecord(__PRETTY_FUNCTION__, tag, __VA_ARGS__)
+#  define LOG_SET_TIME(time)  (log_event_time = (time))
+#  define LOG_EVENT_DUMP()    LogEventDump(stderr)
+
+#else
+
+#  define LOG_WRITE(tag, ...) PrintLog(__PRETTY_FUNCTION__, tag, __VA_ARGS__)
+#  define LOG_SET_TIME(time)  do { } while (0)
+#  define LOG_EVENT_DUMP()    do { } while (0)
+
+#endif /* LOG_EVENTS */
+
+/* ----------------------------------------------------------------- Levels */
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#  define LOGE(...) LOG_WRITE("ERROR", __VA_ARGS__)
+#else
+#  define LOGE(...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#  define LOGI(...) LOG_WRITE("INFO", __VA_ARGS__)
+#else
+#  define LOGI(...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#  define LOGD(...) LOG_WRITE("DEBUG", __VA_ARGS__)
+#else
+#  define LOGD(...) do { } while (0)
+#endif
+
+#define LOG(...) LOGD(__VA_ARGS__)
@@ -0,0 +1,332 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * A prefetcher assembled at compile time from four stages:
+ *
+ *   Trainer    learns from every demand access, and from every completed
+ *              prefetch if it hides TrainerBase::Complete. Occupancy tells
+ *              the fraction of its tables in use, negative if unknown.
+ *              In a batch, Prepare computes what only depends on the PCs
+ *              for the whole batch, then TrainAt trains on access i of it.
+ *                void Init();
+ *                void Train(const AccessStat& stat, Addr block);
+ *                void Complete(Addr block);
+ *                double Occupancy() const;
+ *                void Prepare(const Addr* pcs, int count);
+ *                template <class Self>
+ *                void TrainAt(Self& self, const AccessStat& stat,
+ *                             Addr block, int i);
+ *
+ *   Predictor  turns what the trainer learned into candidates, which it
+ *              pushes to the sink with a priority. It scales its degree or
+ *              distance with sink.Degree(max), 0 meaning off.
+ *                void Init();
+ *                template <class Sink>
+ *                void Predict(const AccessStat& stat, Addr block,
+ *                             Trainer& trainer, Sink& sink);
+ *
+ *   Filter     drops the candidates already cached or in flight
+ *              (PrefetchFilter).
+ *
+ *   Throttle   measures the usefulness of the prefetches and sets the
+ *              degree (FeedbackController).
+ *
+ *   Issuer     holds the candidates until the prefetch queue has room
+ *              (PendingPrefetchQueue).
+ *
+ * With -DPREFETCH_ATTRIBUTION, the pipeline also follows every prefetch
+ * from the PC which triggered it to its first use and prints a per-PC
+ * report with the other statistics (PrefetchAttribution).
+ *
+ * Stages are plain classes called through templates, so nothing on the
+ * access path is virtual. CombinedTrainer and CombinedPredictor run two
+ * stages side by side, which is all a hybrid needs.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+
+#include "access_batch.hh"
+#include "prefetch_feedback.hh"
+#include "prefetch_filter.hh"
+#include "pending_prefetch.hh"
+
+#ifdef PREFETCH_ATTRIBUTION
+#  include "prefetch_attribution.hh"
+#endif /* PREFETCH_ATTRIBUTION */
+
+/* Accesses of a batch handled at once, the rest waits for the next round */
+#ifndef PREFETCH_BATCH_SIZE
+#  define PREFETCH_BATCH_SIZE 64
+#endif /* PREFETCH_BATCH_SIZE */
+
+/* ------------------------------------------------------------ Composition */
+
+/* Default hooks of the trainers, hidden by the ones which need them */
+class TrainerBase
+{
+public:
+    void Complete(Addr block) { }
+    double Occupancy() const { return -1; }
+
+    /* Nothing prepared, every access of a batch is trained alone. The
+       trainer is passed again as self, as its own Train hides nothing
+       here. */
+    void Prepare(const Addr* pcs, int count) { }
+
+    template <class Self>
+    void TrainAt(Self& self, const AccessStat& stat, Addr block, int i)
+    {
+        self.Train(stat, block);
+    }
+};
+
+/* Trainer of the predictors which only look at the current access */
+class NullTrainer : public TrainerBase
+{
+public:
+    void Init() { }
+    void Train(const AccessStat& stat, Addr block) { }
+};
+
+template <class A, class B>
+class CombinedTrainer : public TrainerBase
+{
+public:
+    A First;
+    B Second;
+
+    void Init()
+    {
+        First.Init();
+        Second.Init();
+    }
+
+    void Train(const AccessStat& stat, Addr block)
+    {
+        First.Train(stat, block);
+        Second.Train(stat, block);
+    }
+
+    void Complete(Addr block)
+    {
+        First.Complete(block);
+        Second.Complete(block);
+    }
+
+    void Prepare(const Addr* pcs, int count)
+    {
+        First.Prepare(pcs, count);
+        Second.Prepare(pcs, count);
+    }
+
+    template <class Self>
+    void TrainAt(Self& self, const AccessStat& stat, Addr block, int i)
+    {
+        First.TrainAt(First, stat, block, i);
+        Second.TrainAt(Second, stat, block, i);
+    }
+
+    /* The fuller of the two */
+    double Occupancy() const
+    {
+        double a = First.Occupancy();
+        double b = Second.Occupancy();
+        return (a > b) ? a : b;
+    }
+};
+
+/* Runs both predictors, each on its own part of a CombinedTrainer */
+template <class A, class B>
+class CombinedPredictor
+{
+public:
+    A First;
+    B Second;
+
+    void Init()
+    {
+        First.Init();
+        Second.Init();
+    }
+
+    template <class TrainerA, class TrainerB, class Sink>
+    void Predict(const AccessStat& stat, Addr block,
+                 CombinedTrainer<TrainerA, TrainerB>& trainer, Sink& sink)
+    {
+        First.Predict(stat, block, trainer.First, sink);
+        Second.Predict(stat, block, trainer.Second, sink);
+    }
+};
+
+/* --------------------------------------------------------------- Pipeline */
+template <class Trainer, class Predictor,
+          class Filter = PrefetchFilter,
+          class Throttle = FeedbackController,
+          class Issuer = PendingPrefetchQueue<Filter, Throttle> >
+class PrefetchPipeline
+{
+private:
+    int mStartLevel;
+
+    Trainer mTrainer;
+    Predictor mPredictor;
+    Filter mFilter;
+    Throttle mThrottle;
+    Issuer mIssuer;
+
+    Addr mBlocks[PREFETCH_BATCH_SIZE]; /* Blocks of the current round */
+    Addr mPc; /* PC of the access being predicted */
+
+#ifdef PREFETCH_ATTRIBUTION
+    PrefetchAttribution mAttribution;
+#endif /* PREFETCH_ATTRIBUTION */
+
+    /* The issuer refers to the filter and the throttle of its own pipeline */
+    PrefetchPipeline(const PrefetchPipeline&);
+    PrefetchPipeline& operator=(const PrefetchPipeline&);
+
+public:
+    PrefetchPipeline(int startLevel = FEEDBACK_MAX_LEVEL)
+        : mStartLevel(startLevel), mThrottle(startLevel),
+          mIssuer(mFilter, mThrottle), mPc(0)
+    { }
+
+    Trainer& GetTrainer() { return mTrainer; }
+    Predictor& GetPredictor() { return mPredictor; }
+    const Throttle& GetThrottle() const { return mThrottle; }
+
+    void Init()
+    {
+        mTrainer.Init();
+        mPredictor.Init();
+        mFilter.Reset();
+        mThrottle.Reset(mStartLevel);
+        mIssuer.Reset();
+        mPc = 0;
+
+#ifdef PREFETCH_ATTRIBUTION
+        mAttribution.Reset();
+#endif /* PREFETCH_ATTRIBUTION */
+    }
+
+    void Access(const AccessStat& stat)
+    {
+        Addr block = stat.mem_addr & ~(Addr)(BLOCK_SIZE - 1);
+
+        /* Trains first, while the prefetch bit of the block is still set */
+        mTrainer.Train(stat, block);
+
+        Predict(stat, block);
+    }
+
+    /* Same as Access on every access of the batch in turn. The blocks and
+       what the trainer prepares are computed in plain loops over arrays,
+       which GCC vectorizes at -O3; the updates of the tables stay in order,
+       interleaved with the cache. */
+    void Access(const AccessBatch& batch, AccessDemand demand, void* context)
+    {
+        for (int first = 0; first < batch.count; first += PREFETCH_BATCH_SIZE)
+        {
+            int count = batch.count - first;
+            if (count > PREFETCH_BATCH_SIZE) count = PREFETCH_BATCH_SIZE;
+
+            const Addr* addrs = batch.mem_addr + first;
+            for (int i = 0; i < count; ++i)
+                mBlocks[i] = addrs[i] & ~(Addr)(BLOCK_SIZE - 1);
+
+            mTrainer.Prepare(batch.pc + first, count);
+
+            for (int i = 0; i < count; ++i)
+            {
+                demand(context, first + i);
+
+                AccessStat stat;
+                stat.pc = batch.pc[first + i];
+                stat.mem_addr = addrs[i];
+                stat.time = batch.time[first + i];
+                stat.miss = batch.miss[first + i];
+
+                LOG_SET_TIME(stat.time);
+
+                mTrainer.TrainAt(mTrainer, stat, mBlocks[i], i);
+                Predict(stat, mBlocks[i]);
+            }
+        }
+    }
+
+    void Complete(Addr addr)
+    {
+        mTrainer.Complete(addr);
+        mThrottle.Complete(addr);
+        mFilter.Complete(addr);
+
+#ifdef PREFETCH_ATTRIBUTION
+        mAttribution.Complete(addr);
+#endif /* PREFETCH_ATTRIBUTION */
+
+        /* A slot of the prefetch queue is free */
+        mIssuer.Drain(*this);
+    }
+
+    double Occupancy() const
+    {
+        return mTrainer.Occupancy();
+    }
+
+    void Print(FILE* file, const char* name) const
+    {
+        mThrottle.Print(file, name);
+        mFilter.Print(file, name);
+        mIssuer.Print(file, name);
+
+#ifdef PREFETCH_ATTRIBUTION
+        mAttribution.Print(file, name);
+#endif /* PREFETCH_ATTRIBUTION */
+    }
+
+private:
+    void Predict(const AccessStat& stat, Addr block)
+    {
+#ifdef PREFETCH_ATTRIBUTION
+        /* Before the throttle clears the prefetch bit */
+        mAttribution.Access(block, stat.pc, stat.miss);
+#endif /* PREFETCH_ATTRIBUTION */
+
+        mThrottle.Access(block, stat.miss);
+        mIssuer.Access(block, stat.time);
+
+        mPc = stat.pc;
+        mPredictor.Predict(stat, block, mTrainer, *this);
+
+        mIssuer.Drain(*this);
+    }
+
+public:
+    /* Sink of the predictor */
+    int Degree(int max) const
+    {
+        return mThrottle.Scale(max);
+    }
+
+    bool Push(Addr addr, int priority)
+    {
+        if (addr > MAX_PHYS_MEM_ADDR) return false;
+        return mIssuer.Push(addr, priority, mPc);
+    }
+
+    /* Observer of the issuer */
+    void Issued(Addr block, Addr pc)
+    {
+#ifdef PREFETCH_ATTRIBUTION
+        mAttribution.Issue(block, pc, mThrottle.Level());
+#endif /* PREFETCH_ATTRIBUTION */
+    }
+};
@@ -0,0 +1,221 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   Pierre Michaud, "Best-Offset Hardware Prefetching", HPCA 2016
+ */
+
+#pragma once
+
+#include <cstring>
+#include <stdint.h>
+
+/* Recent requests remembered, must be a power of two */
+#ifndef BO_RR_SIZE
+#  define BO_RR_SIZE 256
+#endif /* BO_RR_SIZE */
+
+/* A learning phase ends when an offset reaches this score... */
+#ifndef BO_SCORE_MAX
+#  define BO_SCORE_MAX 31
+#endif /* BO_SCORE_MAX */
+
+/* ...or after this many rounds over the offsets */
+#ifndef BO_ROUND_MAX
+#  define BO_ROUND_MAX 100
+#endif /* BO_ROUND_MAX */
+
+/* Prefetching is off while the best offset scores no more than this */
+#ifndef BO_BAD_SCORE
+#  define BO_BAD_SCORE 1
+#endif /* BO_BAD_SCORE */
+
+/* Number of blocks prefetched per trigger, at offset, 2 * offset, ... */
+#ifndef BO_DEGREE
+#  define BO_DEGREE 1
+#endif /* BO_DEGREE */
+
+#define BO_PAGE_SIZE 4096
+
+/* Offsets in blocks whose prime factors are 2, 3 and 5 only */
+static const int BO_OFFSETS[] = {
+    1, 2, 3, 4, 5, 6, 8, 9, 10, 12, 15, 16, 18, 20, 24, 25, 27, 30, 32, 36,
+    40, 45, 48, 50, 54, 60, 64
+};
+
+#define BO_NUM_OFFSETS (int)(sizeof(BO_OFFSETS) / sizeof(BO_OFFSETS[0]))
+
+/**
+ * Learns the single offset which would have made the prefetches timely.
+ *
+ * The recent requests table holds the base block Y - D of every prefetch
+ * Y = X + D which completed. On every trigger access X, a miss or the first
+ * hit on a prefetched block, the next offset d of the list is tested: if
+ * X - d is in the table, a prefetch at offset d issued when X - d was
+ * accessed would have been on time, and d scores a point. A learning phase
+ * ends when an offset reaches BO_SCORE_MAX or after BO_ROUND_MAX rounds
+ * over the list, then the best offset becomes the prefetch offset.
+ *
+ * When even the best offset scores no more than BO_BAD_SCORE, prefetching
+ * is off and the accessed blocks themselves go into the table, so the
+ * learning goes on without prefetches.
+ */
+class BestOffsetTrainer : public TrainerBase
+{
+private:
+    Addr mRr[BO_RR_SIZE];
+    int mScores[BO_NUM_OFFSETS];
+    int mTest;  /* Next offset to test */
+    int mRound;
+
+    int mOffset; /* Current prefetch offset in blocks, 0 if off */
+    int mPhases;
+    int mPhasesOff;
+
+public:
+    /* The current access triggers a prefetch */
+    bool Triggered;
+
+    void Init()
+    {
+        memset(mRr, 0, sizeof(mRr));
+        memset(mScores, 0, sizeof(mScores));
+        mTest = 0;
+        mRound = 0;
+
+        mOffset = 1;
+        mPhases = 0;
+        mPhasesOff = 0;
+
+        Triggered = false;
+    }
+
+    void Train(const AccessStat& stat, Addr block)
+    {
+        Triggered = stat.miss || get_prefetch_bit(block);
+        if (!Triggered) return;
+
+        Learn(block);
+
+        if (mOffset == 0) Insert(block);
+    }
+
+    void Complete(Addr addr)
+    {
+        if (mOffset == 0) return;
+
+        Addr block = addr & ~(Addr)(BLOCK_SIZE - 1);
+        Addr base = block - (Addr)mOffset * BLOCK_SIZE;
+
+        /* The prefetch never left the page of its base block */
+        if ((base & ~(Addr)(BO_PAGE_SIZE - 1)) ==
+            (block & ~(Addr)(BO_PAGE_SIZE - 1)))
+            Insert(base);
+    }
+
+    double Occupancy() const
+    {
+        int valid = 0;
+
+        for (int i = 0; i < BO_RR_SIZE; ++i)
+            valid += (mRr[i] != 0);
+
+        return (double)valid / BO_RR_SIZE;
+    }
+
+    int Offset() const { return mOffset; }
+    int Phases() const { return mPhases; }
+    int PhasesOff() const { return mPhasesOff; }
+
+private:
+    Addr& Slot(Addr block)
+    {
+        Addr index = block / BLOCK_SIZE;
+        return mRr[(index ^ (index >> 8)) & (BO_RR_SIZE - 1)];
+    }
+
+    void Insert(Addr block) { Slot(block) = block; }
+
+    bool Hit(Addr block) { return block != 0 && Slot(block) == block; }
+
+    void Learn(Addr block)
+    {
+        int offset = BO_OFFSETS[mTest];
+        Addr base = block - (Addr)offset * BLOCK_SIZE;
+
+        bool samePage = (base & ~(Addr)(BO_PAGE_SIZE - 1)) ==
+                        (block & ~(Addr)(BO_PAGE_SIZE - 1));
+
+        if (samePage && Hit(base) && ++mScores[mTest] >= BO_SCORE_MAX)
+        {
+            EndPhase();
+            return;
+        }
+
+        if (++mTest == BO_NUM_OFFSETS)
+        {
+            mTest = 0;
+            if (++mRound >= BO_ROUND_MAX) EndPhase();
+        }
+    }
+
+    void EndPhase()
+    {
+        int best = 0;
+
+        for (int i = 1; i < BO_NUM_OFFSETS; ++i)
+            if (mScores[i] > mScores[best]) best = i;
+
+        if (mScores[best] > BO_BAD_SCORE)
+            mOffset = BO_OFFSETS[best];
+        else
+        {
+            mOffset = 0;
+            ++mPhasesOff;
+        }
+
+        LOGD("best_offset: offset = %d, score = %d",
+             BO_OFFSETS[best], mScores[best]);
+
+        memset(mScores, 0, sizeof(mScores));
+        mTest = 0;
+        mRound = 0;
+        ++mPhases;
+    }
+};
+
+/**
+ * On a trigger access X, prefetches X + D, X + 2D, ... up to the degree,
+ * without leaving the page of X.
+ */
+class BestOffsetPredictor
+{
+public:
+    void Init() { }
+
+    template <class Sink>
+    void Predict(const AccessStat& stat, Addr block, BestOffsetTrainer& bo,
+                 Sink& sink)
+    {
+        if (!bo.Triggered || bo.Offset() == 0) return;
+
+        Addr page = block & ~(Addr)(BO_PAGE_SIZE - 1);
+        int degree = sink.Degree(BO_DEGREE);
+
+        for (int i = 1; i <= degree; ++i)
+        {
+            Addr pfAddr = block + (Addr)bo.Offset() * BLOCK_SIZE * i;
+            if ((pfAddr & ~(Addr)(BO_PAGE_SIZE - 1)) != page) break;
+
+            LOGD("push_prefetch: addr = 0x%016x, offset = %d, "
+                 "current_queue_size = %d",
+                 pfAddr, bo.Offset(), current_queue_size());
+            sink.Push(pfAddr, degree - i + 1);
+        }
+    }
+};
@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   Kyle J. Nesbit, James E. Smith, "Data Cache Prefetching Using a Global
+ *     History Buffer", HPCA 2004
+ */
+
+#pragma once
+
+#include <cstring>
+#include <stdint.h>
+
+/* Misses remembered, must be a power of two */
+#ifndef GHB_SIZE
+#  define GHB_SIZE 256
+#endif /* GHB_SIZE */
+
+/* Delta pairs indexed, must be a power of two */
+#ifndef GHB_INDEX_SIZE
+#  define GHB_INDEX_SIZE 256
+#endif /* GHB_INDEX_SIZE */
+
+/* Number of deltas replayed per miss */
+#ifndef GHB_DEGREE
+#  define GHB_DEGREE 4
+#endif /* GHB_DEGREE */
+
+/**
+ * Global history buffer: a circular array of the last GHB_SIZE miss
+ * addresses, in the order of the misses. Every entry links to the previous
+ * entry where the same pair of global deltas ended, and the index table
+ * points to the most recent entry of every pair, so the table only needs a
+ * head per key.
+ *
+ * Entries are named by their sequence number; an entry or a link is only
+ * valid while its sequence number is still in the buffer.
+ */
+class GhbTrainer : public TrainerBase
+{
+public:
+    enum { NIL = -1 };
+
+private:
+    struct Entry
+    {
+        Addr Block;
+        int64_t Link; /* Previous entry with the same delta pair, or NIL */
+    };
+
+    struct IndexEntry
+    {
+        uint64_t Key;
+        int64_t Head; /* Most recent entry with this delta pair, or NIL */
+    };
+
+    Entry mBuffer[GHB_SIZE];
+    IndexEntry mIndex[GHB_INDEX_SIZE];
+    int64_t mNext; /* Sequence number of the next miss */
+
+public:
+    void Init()
+    {
+        memset(mBuffer, 0, sizeof(mBuffer));
+
+        for (int i = 0; i < GHB_INDEX_SIZE; ++i)
+        {
+            mIndex[i].Key = 0;
+            mIndex[i].Head = NIL;
+        }
+
+        mNext = 0;
+    }
+
+    void Train(const AccessStat& stat, Addr block)
+    {
+        if (!stat.miss) return;
+
+        int64_t seq = mNext++;
+        Entry& entry = mBuffer[seq & (GHB_SIZE - 1)];
+
+        entry.Block = block;
+        entry.Link = NIL;
+
+        if (seq < 2) return;
+
+        IndexEntry& index = GetIndex(Key(seq));
+
+        if (index.Key == Key(seq) && Valid(index.Head))
+            entry.Link = index.Head;
+
+        index.Key = Key(seq);
+        index.Head = seq;
+    }
+
+    double Occupancy() const
+    {
+        return (mNext < GHB_SIZE) ? (double)mNext / GHB_SIZE : 1.0;
+    }
+
+    /* Sequence number of the last miss, NIL if none */
+    int64_t Last() const { return mNext - 1; }
+
+    bool Valid(int64_t seq) const
+    {
+        return seq != NIL && seq >= mNext - GHB_SIZE && seq < mNext;
+    }
+
+    Addr GetBlock(int64_t seq) const
+    {
+        return mBuffer[seq & (GHB_SIZE - 1)].Block;
+    }
+
+    /* Previous occurrence of the delta pair which ended at seq */
+    int64_t GetLink(int64_t seq) const
+    {
+        int64_t link = mBuffer[seq & (GHB_SIZE - 1)].Link;
+        return Valid(link) ? link : NIL;
+    }
+
+    /* Delta in blocks between the miss seq - 1 and the miss seq */
+    int64_t Delta(int64_t seq) const
+    {
+        return ((int64_t)GetBlock(seq) - (int64_t)GetBlock(seq - 1))
+            / BLOCK_SIZE;
+    }
+
+private:
+    uint64_t Key(int64_t seq) const
+    {
+        return ((uint64_t)Delta(seq - 1) << 32) ^ (uint32_t)Delta(seq);
+    }
+
+    IndexEntry& GetIndex(uint64_t key)
+    {
+        uint64_t hash = key * 0x9e3779b97f4a7c15ULL;
+        return mIndex[(hash >> 32) & (GHB_INDEX_SIZE - 1)];
+    }
+};
+
+/**
+ * Global delta correlation (G/DC). On a miss, finds the previous time the
+ * last two global deltas occurred and replays the deltas which followed
+ * them from the missed block. When the history since that occurrence is
+ * shorter than the degree, it is replayed again, as the pattern repeats.
+ */
+class GhbPredictor
+{
+public:
+    void Init() { }
+
+    template <class Sink>
+    void Predict(const AccessStat& stat, Addr block, GhbTrainer& ghb,
+                 Sink& sink)
+    {
+        if (!stat.miss) return;
+
+        int64_t last = ghb.Last();
+        if (!ghb.Valid(last)) return;
+
+        int64_t match = ghb.GetLink(last);
+        if (match == GhbTrainer::NIL) return;
+
+        int degree = sink.Degree(GHB_DEGREE);
+        Addr pfAddr = block;
+        int64_t seq = match;
+
+        for (int i = 0; i < degree; ++i)
+        {
+            /* Replays the deltas between the match and now, in a loop */
+            if (++seq > last) seq = match + 1;
+            if (!ghb.Valid(seq - 1)) break;
+
+            pfAddr += ghb.Delta(seq) * BLOCK_SIZE;
+            if (pfAddr > MAX_PHYS_MEM_ADDR) break;
+
+            LOGD("push_prefetch: addr = 0x%016x, match = %d, "
+                 "current_queue_size = %d",
+                 pfAddr, match, current_queue_size());
+            sink.Push(pfAddr, degree - i);
+        }
+    }
+};
@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Compact entries follow the misses of every PC (see LastMissTable), with
+   access times as 32-bit update counts, which only order the entries. An
+   entry takes 36 bytes instead of 56. */
+#ifdef GROUPED_HISTORY_COMPACT
+#  include "last_miss_table.hh"
+
+#  define ADDR uint32_t
+#  define TICK uint32_t
+
+typedef int16_t DAddr;
+
+#  define DADDR_MIN (-32768)
+#  define DADDR_MAX 32767
+#  define DADDR_UNIT BLOCK_SIZE
+#else
+typedef int64_t DAddr;
+
+#  define DADDR_UNIT 1
+#endif /* GROUPED_HISTORY_COMPACT */
+
+#include "grouped_history.hh"
+
+/* Only meant for grouped_history.hh */
+#ifdef GROUPED_HISTORY_COMPACT
+#  undef ADDR
+#  undef TICK
+#endif /* GROUPED_HISTORY_COMPACT */
+
+#ifndef GROUPED_HISTORY_SIZE
+#  ifdef GROUPED_HISTORY_COMPACT
+#    define GROUPED_HISTORY_SIZE (3 * 1024)
+#  else
+#    define GROUPED_HISTORY_SIZE (2 * 1024)
+#  endif /* GROUPED_HISTORY_COMPACT */
+#endif /* GROUPED_HISTORY_SIZE */
+
+/* Maximum length of a prefetch chain, which never leaves the page */
+#ifndef CHAIN_DEGREE
+#  define CHAIN_DEGREE 4
+#endif /* CHAIN_DEGREE */
+
+#define CHAIN_PAGE_SIZE 4096
+
+/**
+ * History of the delta between every miss and the next one, grouped into
+ * address intervals which share the same delta.
+ */
+class GroupedHistoryTrainer : public TrainerBase
+{
+private:
+    class Callbacks : public GroupedHistoryCallbacks<DAddr>
+    {
+    public:
+        virtual bool CanMerge(const GroupedHistoryEntry<DAddr>& a,
+                              const GroupedHistoryEntry<DAddr>& b)
+        {
+            if (a.Data != b.Data) return false;
+            if (a.LastAddr + BLOCK_SIZE < b.FirstAddr) return false;
+            return true;
+        }
+    };
+
+    Callbacks mCallbacks;
+    GroupedHistory<DAddr> mHistory;
+    Addr mPrevAddr;
+
+#ifdef GROUPED_HISTORY_COMPACT
+    LastMissTable mLastMisses;
+#endif /* GROUPED_HISTORY_COMPACT */
+
+    uint32_t mUpdates;
+    uint64_t mDropped; /* Deltas which did not fit in a compact entry */
+
+public:
+    GroupedHistoryTrainer()
+        : mHistory(mCallbacks, BLOCK_SIZE, GROUPED_HISTORY_SIZE), mPrevAddr(0),
+          mUpdates(0), mDropped(0)
+    { }
+
+    GroupedHistory<DAddr>& History() { return mHistory; }
+    uint64_t Dropped() const { return mDropped; }
+
+    double Occupancy() const
+    {
+        return (double)mHistory.Size() / GROUPED_HISTORY_SIZE;
+    }
+
+    void Init()
+    {
+        mHistory.Clear();
+        mPrevAddr = 0;
+        mUpdates = 0;
+        mDropped = 0;
+
+#ifdef GROUPED_HISTORY_COMPACT
+        mLastMisses.Init();
+#endif /* GROUPED_HISTORY_COMPACT */
+    }
+
+    void Train(const AccessStat& stat, Addr block)
+    {
+        if (!stat.miss) return;
+
+#ifdef GROUPED_HISTORY_COMPACT
+        mPrevAddr = mLastMisses.Swap(stat.pc, block);
+#endif /* GROUPED_HISTORY_COMPACT */
+
+        if (mPrevAddr != 0)
+        {
+            int64_t delta = ((int64_t)block - (int64_t)mPrevAddr) / DADDR_UNIT;
+
+#ifdef GROUPED_HISTORY_COMPACT
+            if (delta < DADDR_MIN || delta > DADDR_MAX) ++mDropped;
+            else mHistory.Update(++mUpdates, mPrevAddr, (DAddr)delta);
+#else
+            mHistory.Update(stat.time, mPrevAddr, delta);
+#endif /* GROUPED_HISTORY_COMPACT */
+
+            LOGD("history_update: time = %d, addr = 0x%016x, delta = %d",
+                 stat.time, mPrevAddr, delta);
+        }
+
+        mPrevAddr = block;
+    }
+};
+
+/**
+ * On a miss, prefetches addr + delta, addr + 2 * delta, ... as long as
+ * every step starts from an address whose next miss was recorded with the
+ * same delta. Without any history for the missed block, prefetches the
+ * next one.
+ */
+class ChainPredictor
+{
+private:
+    /* Marks which steps of the chain start from an address whose next miss
+       was recorded with the same delta */
+    class Cover
+    {
+    public:
+        Addr Start;
+        DAddr Delta;
+        unsigned Covered; /* Bit i is set if step i is covered */
+
+        Cover(Addr start, DAddr delta)
+            : Start(start), Delta(delta), Covered(0)
+        { }
+
+        bool operator()(const GroupedHistoryEntry<DAddr>& entry)
+        {
+            if (entry.Data != Delta) return true;
+
+            for (int i = 0; i < CHAIN_DEGREE; ++i)
+            {
+                Addr src = Start + (int64_t)Delta * DADDR_UNIT * i;
+                if (entry.FirstAddr <= src && src <= entry.LastAddr)
+                    Covered |= 1u << i;
+            }
+
+            return true;
+        }
+    };
+
+public:
+    void Init() { }
+
+    template <class Sink>
+    void Predict(const AccessStat& stat, Addr block,
+                 GroupedHistoryTrainer& trainer, Sink& sink)
+    {
+        int degree = sink.Degree(CHAIN_DEGREE);
+        if (!stat.miss || degree == 0) return;
+
+        GroupedHistoryEntry<DAddr>* entry = trainer.History().Get(block);
+
+        if (entry != NULL && entry->Data != 0)
+            Chain(trainer, block, entry->Data, degree, sink);
+        else
+            sink.Push(block + BLOCK_SIZE, 1);
+    }
+
+private:
+    template <class Sink>
+    void Chain(GroupedHistoryTrainer& trainer, Addr addr, DAddr delta,
+               int degree, Sink& sink)
+    {
+        /* The chain never leaves the page, so neither does the range query */
+        Addr page = addr & ~(Addr)(CHAIN_PAGE_SIZE - 1);
+
+        Cover cover(addr, delta);
+        if (delta > 0)
+            trainer.History().GetRange(addr, page + CHAIN_PAGE_SIZE - 1, cover);
+        else
+            trainer.History().GetRange(page, addr, cover);
+
+        Addr src = addr;
+
+        for (int i = 0; i < degree && (cover.Covered & (1u << i)); ++i)
+        {
+            Addr pfAddr = src + (int64_t)delta * DADDR_UNIT;
+
+            if ((pfAddr & ~(Addr)(CHAIN_PAGE_SIZE - 1)) != page) break;
+            if (pfAddr > MAX_PHYS_MEM_ADDR) break;
+
+            sink.Push(pfAddr, degree - i);
+            src = pfAddr;
+        }
+    }
+};
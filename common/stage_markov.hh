@@ -0,0 +1,364 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   Doug Joseph and Dirk Grunwald, "Prefetching using Markov Predictors",
+ *     Preceedings of the 24th Annual International Symposium on Computer
+ *     Architecture (ISCA '97), p. 252-263, June 1997, Denver, Colorado, USA
+ */
+
+#pragma once
+
+#include <cstring>
+#include <stdint.h>
+
+/* Compact nodes follow the misses of every PC (see LastMissTable), and
+   take 20 bytes instead of 56, so twice the history fits in less memory */
+#ifdef MARKOV_COMPACT
+#  include "last_miss_table.hh"
+
+typedef uint32_t MarkovBlock;
+typedef int16_t MarkovNext;
+typedef uint16_t MarkovCount;
+
+#  define MARKOV_NEXT_MIN (-32768)
+#  define MARKOV_NEXT_MAX 32767
+#else
+typedef Addr MarkovBlock;
+typedef Addr MarkovNext;
+typedef int MarkovCount;
+#endif /* MARKOV_COMPACT */
+
+#ifndef MARKOV_NODES
+#  ifdef MARKOV_COMPACT
+#    define MARKOV_NODES 65535 /* The most a 16-bit count can hold */
+#  else
+#    define MARKOV_NODES 32768
+#  endif /* MARKOV_COMPACT */
+#endif /* MARKOV_NODES */
+
+#if defined(MARKOV_COMPACT) && MARKOV_NODES > 65535
+#  error "MARKOV_NODES does not fit the 16-bit counts of the compact nodes"
+#endif
+
+#define MARKOV_FANOUT 4
+
+/* Number of successors prefetched per miss, the most confident first */
+#ifndef MARKOV_DEGREE
+#  define MARKOV_DEGREE 2
+#endif /* MARKOV_DEGREE */
+
+/* Saturating confidence counter of every successor */
+#define MARKOV_CONF_MAX 7
+
+/* Node hash table, at least twice as large as MARKOV_NODES */
+#ifndef MARKOV_TABLE_BITS
+#  ifdef MARKOV_COMPACT
+#    define MARKOV_TABLE_BITS 17
+#  else
+#    define MARKOV_TABLE_BITS 16
+#  endif /* MARKOV_COMPACT */
+#endif /* MARKOV_TABLE_BITS */
+
+#define MARKOV_TABLE_SIZE (1 << MARKOV_TABLE_BITS)
+
+/* A full table would never end a probe */
+#if MARKOV_TABLE_SIZE < 2 * MARKOV_NODES
+#  error "MARKOV_TABLE_BITS is too small for MARKOV_NODES"
+#endif
+
+/**
+ * Markov model of the miss address stream, built from the last
+ * MARKOV_NODES misses. Every successor of a node has a saturating
+ * confidence counter.
+ */
+class MarkovTrainer : public TrainerBase
+{
+public:
+    struct Node
+    {
+        MarkovBlock Block;
+        MarkovCount Count; /* Count in history, 0 if the slot is empty */
+        uint8_t NumNext;
+        uint8_t Conf[MARKOV_FANOUT]; /* How often each transition occurred */
+        MarkovNext NextMisses[MARKOV_FANOUT]; /* The most recent one is the
+                                                 last */
+    };
+
+private:
+    /* Miss history, a ring buffer of the last MARKOV_NODES misses */
+    MarkovBlock mHistory[MARKOV_NODES];
+    int mHistoryHead;
+    int mHistoryCount;
+
+    /* Open-addressed hash table with linear probing. There are never more
+       nodes than history entries, so it is at most half full */
+    Node mNodes[MARKOV_TABLE_SIZE];
+    int mNodeCount;
+
+#ifdef MARKOV_COMPACT
+    LastMissTable mLastMisses;
+#endif /* MARKOV_COMPACT */
+
+    uint64_t mDropped; /* Transitions which did not fit in a compact node */
+
+public:
+    void Init()
+    {
+        memset(mNodes, 0, sizeof(mNodes));
+        mNodeCount = 0;
+
+        mHistoryHead = 0;
+        mHistoryCount = 0;
+
+#ifdef MARKOV_COMPACT
+        mLastMisses.Init();
+#endif /* MARKOV_COMPACT */
+
+        mDropped = 0;
+    }
+
+    void Train(const AccessStat& stat, Addr block)
+    {
+        if (!stat.miss) return;
+
+#ifdef MARKOV_COMPACT
+        AddMiss(block, mLastMisses.Swap(stat.pc, block));
+#else
+        AddMiss(block, (mHistoryCount > 0)
+            ? mHistory[(mHistoryHead + mHistoryCount - 1) % MARKOV_NODES] : 0);
+#endif /* MARKOV_COMPACT */
+    }
+
+    Node* Find(Addr addr)
+    {
+        Node* node = Slot(Pack(addr));
+        return (node->Count != 0) ? node : NULL;
+    }
+
+    /* Successor i of the node */
+    static Addr GetNext(const Node& node, int i)
+    {
+#ifdef MARKOV_COMPACT
+        return Unpack(node.Block) + (int64_t)node.NextMisses[i] * BLOCK_SIZE;
+#else
+        return node.NextMisses[i];
+#endif /* MARKOV_COMPACT */
+    }
+
+    int NodeCount() const { return mNodeCount; }
+    double Occupancy() const { return (double)mNodeCount / MARKOV_NODES; }
+    uint64_t Dropped() const { return mDropped; }
+
+private:
+    static MarkovBlock Pack(Addr addr)
+    {
+#ifdef MARKOV_COMPACT
+        return (MarkovBlock)(addr / BLOCK_SIZE);
+#else
+        return addr;
+#endif /* MARKOV_COMPACT */
+    }
+
+    static Addr Unpack(MarkovBlock block)
+    {
+#ifdef MARKOV_COMPACT
+        return (Addr)block * BLOCK_SIZE;
+#else
+        return block;
+#endif /* MARKOV_COMPACT */
+    }
+
+    /* Encodes the successor of the node, false if it does not fit */
+    static bool Encode(MarkovBlock block, Addr next, MarkovNext& out)
+    {
+#ifdef MARKOV_COMPACT
+        int64_t delta = ((int64_t)next - (int64_t)Unpack(block)) / BLOCK_SIZE;
+        if (delta < MARKOV_NEXT_MIN || delta > MARKOV_NEXT_MAX) return false;
+
+        out = (MarkovNext)delta;
+#else
+        out = next;
+#endif /* MARKOV_COMPACT */
+        return true;
+    }
+
+    int Hash(MarkovBlock block) const
+    {
+        uint64_t key =
+            (uint64_t)(Unpack(block) / BLOCK_SIZE) * 0x9e3779b97f4a7c15ULL;
+        return (int)(key >> (64 - MARKOV_TABLE_BITS));
+    }
+
+    /* Returns the slot of the node, or the empty slot where it belongs */
+    Node* Slot(MarkovBlock block)
+    {
+        int i = Hash(block);
+
+        while (mNodes[i].Count != 0 && mNodes[i].Block != block)
+            i = (i + 1) & (MARKOV_TABLE_SIZE - 1);
+
+        return &mNodes[i];
+    }
+
+    /* Removes the node, shifting back the following entries of its cluster
+       so that no tombstone is needed */
+    void Remove(Node* node)
+    {
+        int i = node - mNodes;
+        int j = i;
+
+        for (;;)
+        {
+            j = (j + 1) & (MARKOV_TABLE_SIZE - 1);
+            if (mNodes[j].Count == 0) break;
+
+            /* Moves the entry if its home slot is not cyclically in (i, j] */
+            int k = Hash(mNodes[j].Block);
+            if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) continue;
+
+            mNodes[i] = mNodes[j];
+            i = j;
+        }
+
+        mNodes[i].Count = 0;
+        --mNodeCount;
+    }
+
+    void AddMiss(Addr addr, Addr lastMissAddr)
+    {
+        /* Removes the outdated history entry */
+        if (mHistoryCount == MARKOV_NODES)
+        {
+            Node* node = Find(Unpack(mHistory[mHistoryHead]));
+
+            /* If this is the last entry, remove it from the model */
+            if (node != NULL && --node->Count == 0)
+                Remove(node);
+
+            mHistoryHead = (mHistoryHead + 1) % MARKOV_NODES;
+            --mHistoryCount;
+        }
+
+        /* Adds new miss access to history */
+        mHistory[(mHistoryHead + mHistoryCount) % MARKOV_NODES] = Pack(addr);
+        ++mHistoryCount;
+
+        /* Creates new model node if it does not exist and increases the
+           count */
+        Node* node = Slot(Pack(addr));
+        if (node->Count == 0)
+        {
+            node->Block = Pack(addr);
+            node->NumNext = 0;
+            ++mNodeCount;
+        }
+
+        ++node->Count;
+
+        /* Adds the new address to the top of the last miss address
+           prediction */
+        if (lastMissAddr == 0) return;
+
+        LOGD("addr: 0x%016x, last_miss_addr: 0x%016x", addr, lastMissAddr);
+        Node* last = Find(lastMissAddr);
+        if (last == NULL) return;
+
+        MarkovNext next;
+        if (!Encode(last->Block, addr, next))
+        {
+            ++mDropped;
+            return;
+        }
+
+        MarkovNext* nextMisses = last->NextMisses;
+        uint8_t* conf = last->Conf;
+        int i = 0;
+
+        while (i < last->NumNext && nextMisses[i] != next) ++i;
+
+        uint8_t newConf = 1;
+        if (i < last->NumNext)
+        {
+            /* Known transition, strengthens it */
+            newConf = conf[i];
+            if (newConf < MARKOV_CONF_MAX) ++newConf;
+        }
+        else if (i == MARKOV_FANOUT)
+        {
+            /* No room left, ages all the transitions and replaces the least
+               confident one, the oldest one on a tie */
+            i = 0;
+            for (int j = 0; j < MARKOV_FANOUT; ++j)
+            {
+                if (conf[j] > 0) --conf[j];
+                if (conf[j] < conf[i]) i = j;
+            }
+        }
+        else ++last->NumNext;
+
+        /* Moves it to the top */
+        for (; i < last->NumNext - 1; ++i)
+        {
+            nextMisses[i] = nextMisses[i + 1];
+            conf[i] = conf[i + 1];
+        }
+
+        nextMisses[last->NumNext - 1] = next;
+        conf[last->NumNext - 1] = newConf;
+        LOGD("last_miss_node.next_misses.size = %d", last->NumNext);
+    }
+};
+
+/**
+ * On a miss, prefetches up to MARKOV_DEGREE successors of the missed block
+ * in order of confidence, which is also their priority when they have to
+ * wait for the prefetch queue.
+ */
+class MarkovPredictor
+{
+public:
+    void Init() { }
+
+    template <class Sink>
+    void Predict(const AccessStat& stat, Addr block, MarkovTrainer& model,
+                 Sink& sink)
+    {
+        if (!stat.miss) return;
+
+        MarkovTrainer::Node* node = model.Find(block);
+        if (node == NULL) return;
+
+        LOGD("model_prefetch: addr = 0x%016x, node_count = %d, "
+             "predict_count = %d", block, model.NodeCount(), node->NumNext);
+
+        /* Ranks the successors by confidence, the most recent first on a
+           tie */
+        int order[MARKOV_FANOUT];
+        int num = 0;
+
+        for (int i = node->NumNext - 1; i >= 0; --i)
+        {
+            int j = num++;
+            for (; j > 0 && node->Conf[order[j - 1]] < node->Conf[i]; --j)
+                order[j] = order[j - 1];
+            order[j] = i;
+        }
+
+        int degree = sink.Degree(MARKOV_DEGREE);
+
+        for (int i = 0, issued = 0; i < num && issued < degree; ++i)
+        {
+            Addr pfAddr = MarkovTrainer::GetNext(*node, order[i]);
+            int conf = node->Conf[order[i]];
+
+            LOGD("push_prefetch: addr = 0x%016x, conf = %d", pfAddr, conf);
+            if (sink.Push(pfAddr, conf)) ++issued;
+        }
+    }
+};
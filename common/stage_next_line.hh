@@ -0,0 +1,45 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#pragma once
+
+/* Maximum number of blocks prefetched after a miss */
+#ifndef NEXT_LINE_DEGREE
+#  define NEXT_LINE_DEGREE 4
+#endif /* NEXT_LINE_DEGREE */
+
+/**
+ * Prefetches the blocks following a missed block, the nearest first. It
+ * needs no training, so it works with any trainer.
+ */
+class NextLinePredictor
+{
+public:
+    void Init() { }
+
+    template <class Trainer, class Sink>
+    void Predict(const AccessStat& stat, Addr block, Trainer& trainer,
+                 Sink& sink)
+    {
+        if (!stat.miss) return;
+
+        int degree = sink.Degree(NEXT_LINE_DEGREE);
+
+        for (int i = 1; i <= degree; ++i)
+        {
+            Addr pfAddr = block + i * BLOCK_SIZE;
+            if (pfAddr > MAX_PHYS_MEM_ADDR) break;
+
+            LOGD("push_prefetch: addr = 0x%016x, pc=0x%016x, "
+                 "current_queue_size = %d",
+                 pfAddr, stat.pc, current_queue_size());
+            sink.Push(pfAddr, degree - i);
+        }
+    }
+};
@@ -0,0 +1,249 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   Stephen Somogyi, Thomas F. Wenisch, Anastassia Ailamaki, Babak Falsafi,
+ *     Andreas Moshovos, "Spatial Memory Streaming", ISCA 2006
+ */
+
+#pragma once
+
+#include <cstring>
+#include <stdint.h>
+
+/* Region of which the footprint is recorded, at most 64 blocks */
+#ifndef SMS_REGION_SIZE
+#  define SMS_REGION_SIZE 2048
+#endif /* SMS_REGION_SIZE */
+
+#define SMS_REGION_BLOCKS (SMS_REGION_SIZE / BLOCK_SIZE)
+
+/* Footprints are 64-bit masks */
+#if SMS_REGION_SIZE / BLOCK_SIZE > 64
+#  error "SMS_REGION_SIZE holds more than 64 blocks"
+#endif
+
+/* Regions whose generation is being recorded, fully associative */
+#ifndef SMS_AGT_SIZE
+#  define SMS_AGT_SIZE 64
+#endif /* SMS_AGT_SIZE */
+
+/* Footprints remembered, must be a power of two */
+#ifndef SMS_PHT_SIZE
+#  define SMS_PHT_SIZE 2048
+#endif /* SMS_PHT_SIZE */
+
+#define SMS_PHT_WAYS 4
+#define SMS_PHT_SETS (SMS_PHT_SIZE / SMS_PHT_WAYS)
+
+/* Maximum number of blocks of a footprint prefetched at once */
+#ifndef SMS_DEGREE
+#  define SMS_DEGREE SMS_REGION_BLOCKS
+#endif /* SMS_DEGREE */
+
+/**
+ * Records which blocks of a region are accessed during a generation, from
+ * the access which triggers it until the region leaves the active
+ * generation table, and stores the footprint in the pattern history table
+ * under the PC and the region offset of the trigger access.
+ *
+ * The interface does not tell about evictions, so a generation ends when
+ * its region is the least recently used one and room is needed. Regions
+ * with a single block accessed are not worth a footprint.
+ */
+class SmsTrainer : public TrainerBase
+{
+private:
+    struct Generation
+    {
+        Addr Region;
+        Addr Pc;
+        uint64_t Footprint;
+        uint64_t LastUse;
+        int Offset; /* Block of the trigger access */
+        bool Valid;
+    };
+
+    struct Pattern
+    {
+        uint64_t Key;
+        uint64_t Footprint;
+        uint64_t LastUse;
+        bool Valid;
+    };
+
+    Generation mAgt[SMS_AGT_SIZE];
+    Pattern mPht[SMS_PHT_SETS][SMS_PHT_WAYS];
+    uint64_t mClock;
+
+public:
+    /* Footprint to stream after a trigger access, 0 if none */
+    uint64_t Triggered;
+    int TriggerOffset;
+
+    void Init()
+    {
+        memset(mAgt, 0, sizeof(mAgt));
+        memset(mPht, 0, sizeof(mPht));
+        mClock = 0;
+
+        Triggered = 0;
+        TriggerOffset = 0;
+    }
+
+    void Train(const AccessStat& stat, Addr block)
+    {
+        Addr region = block & ~(Addr)(SMS_REGION_SIZE - 1);
+        int offset = (block - region) / BLOCK_SIZE;
+
+        ++mClock;
+        Triggered = 0;
+
+        Generation* victim = &mAgt[0];
+
+        for (int i = 0; i < SMS_AGT_SIZE; ++i)
+        {
+            Generation& gen = mAgt[i];
+
+            if (gen.Valid && gen.Region == region)
+            {
+                gen.Footprint |= 1ULL << offset;
+                gen.LastUse = mClock;
+                return;
+            }
+
+            if (!gen.Valid || (victim->Valid && gen.LastUse < victim->LastUse))
+                victim = &gen;
+        }
+
+        /* Trigger access, a new generation starts */
+        if (victim->Valid) End(*victim);
+
+        victim->Region = region;
+        victim->Pc = stat.pc;
+        victim->Offset = offset;
+        victim->Footprint = 1ULL << offset;
+        victim->LastUse = mClock;
+        victim->Valid = true;
+
+        Pattern* pattern = Find(Key(stat.pc, offset));
+        if (pattern != NULL)
+        {
+            pattern->LastUse = mClock;
+            Triggered = pattern->Footprint & ~(1ULL << offset);
+            TriggerOffset = offset;
+        }
+    }
+
+    /* Footprints stored in the pattern history table */
+    double Occupancy() const
+    {
+        int valid = 0;
+
+        for (int i = 0; i < SMS_PHT_SETS; ++i)
+            for (int j = 0; j < SMS_PHT_WAYS; ++j)
+                valid += mPht[i][j].Valid;
+
+        return (double)valid / SMS_PHT_SIZE;
+    }
+
+private:
+    static uint64_t Key(Addr pc, int offset)
+    {
+        return ((uint64_t)pc << 6) | (uint64_t)offset;
+    }
+
+    Pattern* Set(uint64_t key)
+    {
+        uint64_t hash = key * 0x9e3779b97f4a7c15ULL;
+        return mPht[(hash >> 40) % SMS_PHT_SETS];
+    }
+
+    Pattern* Find(uint64_t key)
+    {
+        Pattern* set = Set(key);
+
+        for (int i = 0; i < SMS_PHT_WAYS; ++i)
+            if (set[i].Valid && set[i].Key == key) return &set[i];
+
+        return NULL;
+    }
+
+    /* Stores the footprint of a generation which ends */
+    void End(const Generation& gen)
+    {
+        uint64_t key = Key(gen.Pc, gen.Offset);
+        Pattern* pattern = Find(key);
+
+        if (gen.Footprint == (1ULL << gen.Offset))
+        {
+            /* Only the trigger block was accessed this time */
+            if (pattern != NULL) pattern->Valid = false;
+            return;
+        }
+
+        if (pattern == NULL)
+        {
+            Pattern* set = Set(key);
+            pattern = &set[0];
+
+            for (int i = 1; i < SMS_PHT_WAYS && pattern->Valid; ++i)
+                if (!set[i].Valid || set[i].LastUse < pattern->LastUse)
+                    pattern = &set[i];
+        }
+
+        pattern->Key = key;
+        pattern->Footprint = gen.Footprint;
+        pattern->LastUse = mClock;
+        pattern->Valid = true;
+    }
+};
+
+/**
+ * On a trigger access with a known footprint, streams the whole footprint
+ * of the region, the blocks nearest to the trigger first.
+ */
+class SmsPredictor
+{
+public:
+    void Init() { }
+
+    template <class Sink>
+    void Predict(const AccessStat& stat, Addr block, SmsTrainer& sms,
+                 Sink& sink)
+    {
+        uint64_t footprint = sms.Triggered;
+        if (footprint == 0) return;
+
+        Addr region = block & ~(Addr)(SMS_REGION_SIZE - 1);
+        int degree = sink.Degree(SMS_DEGREE);
+        int issued = 0;
+
+        for (int dist = 1; dist < SMS_REGION_BLOCKS && issued < degree; ++dist)
+        {
+            int offsets[2] = { sms.TriggerOffset + dist,
+                               sms.TriggerOffset - dist };
+
+            for (int i = 0; i < 2 && issued < degree; ++i)
+            {
+                int offset = offsets[i];
+                if (offset < 0 || offset >= SMS_REGION_BLOCKS) continue;
+                if (!(footprint & (1ULL << offset))) continue;
+
+                Addr pfAddr = region + offset * BLOCK_SIZE;
+                if (pfAddr > MAX_PHYS_MEM_ADDR) continue;
+
+                LOGD("push_prefetch: addr = 0x%016x, pc=0x%016x, "
+                     "current_queue_size = %d",
+                     pfAddr, stat.pc, current_queue_size());
+                sink.Push(pfAddr, SMS_REGION_BLOCKS - dist);
+                ++issued;
+            }
+        }
+    }
+};
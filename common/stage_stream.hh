@@ -0,0 +1,240 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   Alan Jay Smith, "Sequential Program Prefetching in Memory Hierarchies",
+ *     Computer, vol. 11, no. 12, pp. 7-21, Dec. 1978
+ *   Fredrik Dahlgren, Michel Dubois, Per Stenstrom, "Fixed and Adaptive
+ *     Sequential Prefetching in Shared Memory Multiprocessors", ICPP 1993
+ */
+
+#pragma once
+
+#include <cstring>
+#include <stdint.h>
+
+/* Streams followed at the same time, least recently used replaced */
+#ifndef STREAM_COUNT
+#  define STREAM_COUNT 16
+#endif /* STREAM_COUNT */
+
+/* Distance in blocks from the head within which an access joins a stream */
+#ifndef STREAM_WINDOW
+#  define STREAM_WINDOW 16
+#endif /* STREAM_WINDOW */
+
+/* Degree of a new stream, doubled on every tagged hit up to the maximum */
+#ifndef STREAM_START_DEGREE
+#  define STREAM_START_DEGREE 1
+#endif /* STREAM_START_DEGREE */
+
+#ifndef STREAM_MAX_DEGREE
+#  define STREAM_MAX_DEGREE 8
+#endif /* STREAM_MAX_DEGREE */
+
+/* Misses a new stream needs before it prefetches, so isolated misses do
+   not waste prefetches */
+#ifndef STREAM_CONFIRM
+#  define STREAM_CONFIRM 2
+#endif /* STREAM_CONFIRM */
+
+/**
+ * Follows up to STREAM_COUNT sequential streams, ascending or descending.
+ *
+ * A stream is triggered by a miss or by the first demand hit on a block it
+ * prefetched, which still has its prefetch bit set (the feedback controller
+ * clears it right after). Without the tagged hits, a captured stream would
+ * only hit and never trigger again. Every tagged hit proves the stream
+ * right and doubles its degree; a miss inside the stream means it is not
+ * far enough ahead, which a larger degree also helps.
+ *
+ * A miss outside every stream starts an ascending one, which prefetches
+ * once STREAM_CONFIRM misses fell into it. If the second miss is below its
+ * head, the stream turns out to be descending.
+ */
+class StreamTrainer : public TrainerBase
+{
+public:
+    struct Stream
+    {
+        Addr Head;     /* Last block which triggered the stream */
+        Addr Frontier; /* Furthest block prefetched */
+        int Dir;       /* +1 or -1 */
+        int Degree;
+        int Triggers;
+        uint64_t LastUse;
+        bool Valid;
+    };
+
+private:
+    Stream mStreams[STREAM_COUNT];
+    uint64_t mClock;
+
+    uint64_t mAllocated;
+    uint64_t mTaggedHits;
+
+public:
+    /* Stream to continue after the current access, NULL if none */
+    Stream* Triggered;
+
+    void Init()
+    {
+        memset(mStreams, 0, sizeof(mStreams));
+        mClock = 0;
+        mAllocated = mTaggedHits = 0;
+
+        Triggered = NULL;
+    }
+
+    void Train(const AccessStat& stat, Addr block)
+    {
+        Triggered = NULL;
+
+        bool tagged = !stat.miss && get_prefetch_bit(block);
+        if (!stat.miss && !tagged) return;
+
+        ++mClock;
+
+        Stream* stream = Find(block);
+
+        if (stream == NULL)
+        {
+            if (!tagged) Allocate(block);
+            return;
+        }
+
+        /* The second miss of a young stream below its head */
+        if (!tagged && stream->Triggers == 1 &&
+            Distance(stream->Head, block) * stream->Dir < 0)
+        {
+            stream->Dir = -stream->Dir;
+            stream->Frontier = stream->Head;
+        }
+
+        if (tagged) ++mTaggedHits;
+
+        /* A stream still being confirmed keeps its start degree */
+        if (stream->Triggers >= STREAM_CONFIRM)
+            stream->Degree = (stream->Degree * 2 < STREAM_MAX_DEGREE)
+                ? stream->Degree * 2 : STREAM_MAX_DEGREE;
+
+        /* Accesses behind the head do not move it back */
+        if (Distance(stream->Head, block) * stream->Dir > 0)
+            stream->Head = block;
+
+        /* The program overtook the prefetches */
+        if (Distance(stream->Frontier, block) * stream->Dir > 0)
+            stream->Frontier = block;
+
+        ++stream->Triggers;
+        stream->LastUse = mClock;
+
+        if (stream->Triggers >= STREAM_CONFIRM) Triggered = stream;
+    }
+
+    double Occupancy() const
+    {
+        int valid = 0;
+
+        for (int i = 0; i < STREAM_COUNT; ++i)
+            valid += mStreams[i].Valid;
+
+        return (double)valid / STREAM_COUNT;
+    }
+
+    uint64_t Allocated() const { return mAllocated; }
+    uint64_t TaggedHits() const { return mTaggedHits; }
+
+private:
+    static int64_t Distance(Addr from, Addr to)
+    {
+        return ((int64_t)to - (int64_t)from) / BLOCK_SIZE;
+    }
+
+    Stream* Find(Addr block)
+    {
+        Stream* best = NULL;
+        int64_t bestDist = STREAM_WINDOW + 1;
+
+        for (int i = 0; i < STREAM_COUNT; ++i)
+        {
+            Stream& stream = mStreams[i];
+            if (!stream.Valid) continue;
+
+            int64_t dist = Distance(stream.Head, block);
+            if (dist < 0) dist = -dist;
+
+            if (dist < bestDist)
+            {
+                best = &stream;
+                bestDist = dist;
+            }
+        }
+
+        return best;
+    }
+
+    void Allocate(Addr block)
+    {
+        Stream* victim = &mStreams[0];
+
+        for (int i = 1; i < STREAM_COUNT && victim->Valid; ++i)
+            if (!mStreams[i].Valid || mStreams[i].LastUse < victim->LastUse)
+                victim = &mStreams[i];
+
+        victim->Head = block;
+        victim->Frontier = block;
+        victim->Dir = 1;
+        victim->Degree = STREAM_START_DEGREE;
+        victim->Triggers = 1;
+        victim->LastUse = mClock;
+        victim->Valid = true;
+
+        ++mAllocated;
+    }
+};
+
+/**
+ * Prefetches the blocks of the triggered stream from its frontier up to
+ * degree blocks ahead of the trigger, so a stream in steady state issues
+ * one new block per tagged hit and the nearest blocks go first.
+ */
+class StreamPredictor
+{
+public:
+    void Init() { }
+
+    template <class Sink>
+    void Predict(const AccessStat& stat, Addr block, StreamTrainer& streams,
+                 Sink& sink)
+    {
+        StreamTrainer::Stream* stream = streams.Triggered;
+        if (stream == NULL) return;
+
+        int degree = sink.Degree(stream->Degree);
+        int64_t step = (int64_t)stream->Dir * BLOCK_SIZE;
+
+        for (int i = 1; i <= degree; ++i)
+        {
+            Addr pfAddr = block + step * i;
+
+            /* Already prefetched by an earlier trigger */
+            if (((int64_t)pfAddr - (int64_t)stream->Frontier) * stream->Dir
+                <= 0)
+                continue;
+
+            if (pfAddr > MAX_PHYS_MEM_ADDR) break;
+
+            LOGD("push_prefetch: addr = 0x%016x, pc=0x%016x, "
+                 "current_queue_size = %d",
+                 pfAddr, stat.pc, current_queue_size());
+            sink.Push(pfAddr, degree - i + 1);
+            stream->Frontier = pfAddr;
+        }
+    }
+};
@@ -0,0 +1,371 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   [1] Jean-Loup Baer, Tien-Fu Chen, "An Effective On-Chip Preloading Scheme
+ *       To Reduce Data Access Penalty", in ACM/IEEE Conference on Super-
+ *       -computing, 1991, pp. 176-186
+ *   [2] Johnny K. F. Lee, Alan Jay Smith, "Branch prediction strategies
+ *       and branch target buffer design", Computer, pp. 6-22, Jan. 1984
+ */
+
+#pragma once
+
+#include <cstring>
+#include <stdint.h>
+
+#ifndef RPT_ENTRIES
+#  define RPT_ENTRIES 16384
+#endif /* RPT_ENTRIES */
+
+#define RPT_WAYS 4
+#define RPT_SETS (RPT_ENTRIES / RPT_WAYS)
+
+#ifndef BPT_SIZE
+#  define BPT_SIZE 1024
+#endif /* BPT_SIZE */
+
+/* Number of memory references the lookahead PC runs ahead of the PC. The
+   prefetches have to cover the memory latency: a loop of a few references
+   takes several iterations to do so */
+#ifndef LOOKAHEAD_DISTANCE
+#  define LOOKAHEAD_DISTANCE 16
+#endif /* LOOKAHEAD_DISTANCE */
+
+/**
+ * Reference prediction table [1], which learns the stride of every memory
+ * reference instruction, and branch prediction table [2], which learns the
+ * sequence of memory reference instructions.
+ */
+class RptTrainer : public TrainerBase
+{
+public:
+    enum { STATE_INIT, STATE_TRANSIENT, STATE_STEADY, STATE_NO_PRED };
+
+    /* Two entries per cache line */
+    struct Entry
+    {
+        Addr Pc;
+        Addr PrevAddr;
+        Addr LastPfAddr; /* Last block prefetched on behalf of this entry */
+
+        int32_t Stride;  /* Larger strides are not predicted */
+        uint8_t State;
+        uint8_t Times; /* Number of times the LA-PC is ahead of the PC here */
+        uint8_t Lru;   /* Age in the set, 0 is the most recently used */
+        uint8_t Valid;
+    };
+
+private:
+    struct Set
+    {
+        Entry Ways[RPT_WAYS];
+    } __attribute__((aligned(64)));
+
+    struct BptEntry
+    {
+        Addr Pc;
+        Addr Target; /* Next memory reference instruction */
+        int Conf;    /* 2-bit saturating counter */
+    };
+
+    Set mRpt[RPT_SETS];
+    BptEntry mBpt[BPT_SIZE];
+    Addr mLastPc;
+
+    uint32_t mSets[PREFETCH_BATCH_SIZE]; /* RPT sets of a batch */
+
+public:
+    void Init()
+    {
+        memset(mRpt, 0, sizeof(mRpt));
+        for (int i = 0; i < RPT_SETS; ++i)
+            for (int j = 0; j < RPT_WAYS; ++j)
+                mRpt[i].Ways[j].Lru = RPT_WAYS - 1;
+
+        memset(mBpt, 0, sizeof(mBpt));
+        mLastPc = 0;
+    }
+
+    void Train(const AccessStat& stat, Addr block)
+    {
+        Entry& entry = Execute(stat.pc, GetSet(stat.pc));
+        Access(entry, stat.mem_addr);
+    }
+
+    /* The set of every PC of a batch, a loop without any branch */
+    void Prepare(const Addr* pcs, int count)
+    {
+        for (int i = 0; i < count; ++i)
+            mSets[i] = SetIndex(pcs[i]);
+    }
+
+    template <class Self>
+    void TrainAt(Self& self, const AccessStat& stat, Addr block, int i)
+    {
+        Entry& entry = Execute(stat.pc, mRpt[mSets[i]]);
+        Access(entry, stat.mem_addr);
+    }
+
+    /* Returns the entry of the instruction or NULL, without updating the LRU */
+    Entry* Find(Addr pc)
+    {
+        Set& set = GetSet(pc);
+
+        for (int i = 0; i < RPT_WAYS; ++i)
+            if (set.Ways[i].Valid && set.Ways[i].Pc == pc) return &set.Ways[i];
+
+        return NULL;
+    }
+
+    double Occupancy() const
+    {
+        int valid = 0;
+
+        for (int i = 0; i < RPT_SETS; ++i)
+            for (int j = 0; j < RPT_WAYS; ++j)
+                valid += mRpt[i].Ways[j].Valid;
+
+        return (double)valid / RPT_ENTRIES;
+    }
+
+    /* Returns the predicted next instruction, or 0 if there is none */
+    Addr PredictNextPc(Addr pc)
+    {
+        BptEntry& entry = GetBptEntry(pc);
+        return (entry.Pc == pc) ? entry.Target : 0;
+    }
+
+private:
+    static uint32_t SetIndex(Addr pc)
+    {
+        Addr index = pc >> 2;
+        return (uint32_t)((index ^ (index / RPT_SETS)) % RPT_SETS);
+    }
+
+    Set& GetSet(Addr pc)
+    {
+        return mRpt[SetIndex(pc)];
+    }
+
+    void Touch(Set& set, Entry* entry)
+    {
+        for (int i = 0; i < RPT_WAYS; ++i)
+            if (set.Ways[i].Lru < entry->Lru) ++set.Ways[i].Lru;
+
+        entry->Lru = 0;
+    }
+
+    Entry& Execute(Addr pc, Set& set)
+    {
+        Entry* entry = NULL;
+        Entry* victim = &set.Ways[0];
+
+        for (int i = 0; i < RPT_WAYS; ++i)
+        {
+            Entry& way = set.Ways[i];
+
+            if (way.Valid && way.Pc == pc) { entry = &way; break; }
+
+            /* Invalid entries have the maximum age, so they are taken first */
+            if (way.Lru > victim->Lru || (!way.Valid && victim->Valid))
+                victim = &way;
+        }
+
+        if (entry == NULL)
+        {
+            /* If this instruction is not in the table, replaces the least
+               recently used entry of its set */
+            entry = victim;
+
+            entry->Pc = pc;
+            entry->PrevAddr = 0;
+            entry->LastPfAddr = 0;
+            entry->Stride = 0;
+            entry->State = STATE_INIT;
+            entry->Times = 0;
+            entry->Valid = 1;
+        }
+
+        Touch(set, entry);
+
+        /* Trains the branch prediction of the previous one */
+        if (mLastPc != 0) TrainBpt(mLastPc, pc);
+        mLastPc = pc;
+
+        return *entry;
+    }
+
+    void Access(Entry& entry, Addr addr)
+    {
+        int correct = (entry.PrevAddr + entry.Stride == addr);
+        int64_t stride = (int64_t)(addr - entry.PrevAddr);
+
+        entry.PrevAddr = addr;
+
+        switch (entry.State)
+        {
+        case STATE_INIT:
+            if (correct) entry.State = STATE_STEADY;
+            else SetStride(entry, stride, STATE_TRANSIENT);
+
+            break;
+
+        case STATE_TRANSIENT:
+            if (correct) entry.State = STATE_STEADY;
+            else SetStride(entry, stride, STATE_NO_PRED);
+
+            break;
+
+        case STATE_NO_PRED:
+            if (correct) entry.State = STATE_TRANSIENT;
+            else SetStride(entry, stride, STATE_TRANSIENT);
+
+            break;
+
+        case STATE_STEADY:
+            if (!correct) entry.State = STATE_INIT;
+
+            break;
+        }
+    }
+
+    /* A stride which does not fit on 32 bits could alias a small one, the
+       instruction is not predicted until its stride is small again */
+    static void SetStride(Entry& entry, int64_t stride, int state)
+    {
+        if (stride != (int32_t)stride)
+        {
+            entry.State = STATE_NO_PRED;
+            entry.Stride = 0;
+        }
+        else
+        {
+            entry.State = state;
+            entry.Stride = (int32_t)stride;
+        }
+    }
+
+    BptEntry& GetBptEntry(Addr pc)
+    {
+        return mBpt[(pc >> 2) % BPT_SIZE];
+    }
+
+    void TrainBpt(Addr pc, Addr nextPc)
+    {
+        BptEntry& entry = GetBptEntry(pc);
+
+        if (entry.Pc != pc)
+        {
+            entry.Pc = pc;
+            entry.Target = nextPc;
+            entry.Conf = 1;
+        }
+        else if (entry.Target == nextPc)
+        {
+            if (entry.Conf < 3) ++entry.Conf;
+        }
+        else if (--entry.Conf <= 0)
+        {
+            entry.Target = nextPc;
+            entry.Conf = 1;
+        }
+    }
+};
+
+/**
+ * Lookahead PC [1]. The LA-PC runs up to LOOKAHEAD_DISTANCE memory
+ * references ahead of the PC, following the branch prediction table.
+ * Whenever it meets an instruction in steady state, the address that
+ * instruction will access when the PC gets there is prefetched.
+ */
+class LookaheadPredictor
+{
+private:
+    Addr mLaPc;
+    Addr mPath[LOOKAHEAD_DISTANCE]; /* PCs visited by the LA-PC, oldest first */
+    int mHead;
+    int mCount;
+
+public:
+    void Init()
+    {
+        mLaPc = 0;
+        mHead = 0;
+        mCount = 0;
+    }
+
+    template <class Sink>
+    void Predict(const AccessStat& stat, Addr block, RptTrainer& rpt,
+                 Sink& sink)
+    {
+        if (mCount > 0 && mPath[mHead] == stat.pc)
+        {
+            /* The LA-PC has correctly predicted this instruction */
+            Pop(rpt);
+        }
+        else
+        {
+            /* Misprediction, restarts the LA-PC from the current PC */
+            while (mCount > 0) Pop(rpt);
+            mLaPc = stat.pc;
+        }
+
+        /* Lets the LA-PC run ahead until it is far enough, the throttle
+           keeps it closer to the PC while its prefetches are not useful */
+        int distance = sink.Degree(LOOKAHEAD_DISTANCE);
+
+        while (mCount < distance)
+        {
+            Addr nextPc = rpt.PredictNextPc(mLaPc);
+            if (nextPc == 0) break;
+
+            mLaPc = nextPc;
+            mPath[(mHead + mCount) % LOOKAHEAD_DISTANCE] = nextPc;
+            ++mCount;
+
+            /* The nearest ones are needed first */
+            Prefetch(nextPc, LOOKAHEAD_DISTANCE - mCount, rpt, sink);
+        }
+    }
+
+private:
+    template <class Sink>
+    void Prefetch(Addr pc, int priority, RptTrainer& rpt, Sink& sink)
+    {
+        RptTrainer::Entry* entry = rpt.Find(pc);
+        if (entry == NULL) return;
+
+        if (entry->Times < 255) ++entry->Times;
+
+        /* If it is in steady state, prefetches the address the instruction
+           will access when the PC catches up with the LA-PC */
+        if (entry->State != RptTrainer::STATE_STEADY) return;
+
+        Addr pfAddr = entry->PrevAddr + (int64_t)entry->Stride * entry->Times;
+        pfAddr &= ~(Addr)(BLOCK_SIZE - 1);
+
+        if (pfAddr == entry->LastPfAddr || pfAddr > MAX_PHYS_MEM_ADDR) return;
+        entry->LastPfAddr = pfAddr;
+
+        LOGD("push_prefetch: addr = 0x%016x, pc=0x%016x, "
+             "current_queue_size = %d",
+             pfAddr, pc, current_queue_size());
+        sink.Push(pfAddr, priority);
+    }
+
+    /* Removes the oldest PC of the lookahead path */
+    void Pop(RptTrainer& rpt)
+    {
+        RptTrainer::Entry* entry = rpt.Find(mPath[mHead]);
+        if (entry != NULL && entry->Times > 0) --entry->Times;
+
+        mHead = (mHead + 1) % LOOKAHEAD_DISTANCE;
+        --mCount;
+    }
+};
@@ -0,0 +1,310 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   Marius Grannaes, Magnus Jahre, Lasse Natvig, "Storage Efficient Hardware
+ *     Prefetching using Delta-Correlating Prediction Tables", Journal of
+ *     Instruction-Level Parallelism, vol. 13, 2011
+ */
+
+#include "interface.hh"
+
+#include <cstring>
+#include <stdint.h>
+
+#define DCPT_ENTRIES 256
+#define DCPT_WAYS    4
+#define DCPT_SETS    (DCPT_ENTRIES / DCPT_WAYS)
+#define NUM_DELTAS   16
+
+/* Maximum number of prefetches per access, scaled by the throttle */
+#define MAX_DEGREE   NUM_DELTAS
+
+/* Deltas are stored in blocks, the ones which do not fit are stored as 0
+   and never match a pattern */
+#define MAX_DELTA    32767
+
+/* ---------------------------------------------------------------- Logging */
+#include "prefetch_log.hh"
+
+/* --------------------------------------------------------------- Pipeline */
+#include "prefetch_pipeline.hh"
+#include "prefetch_instances.hh"
+
+/* ------------------------------------ Delta-correlating prediction table */
+struct dcpt_entry_t
+{
+    Addr pc;
+    Addr last_addr;
+    Addr last_pf_addr;
+
+    int16_t deltas[NUM_DELTAS]; /* Circular buffer of the last deltas */
+    uint8_t delta_head;         /* Position of the next delta to write */
+    uint8_t delta_count;
+    uint8_t lru;                /* Age in the set, 0 is the most recent */
+    uint8_t valid;
+};
+
+struct dcpt_set_t
+{
+    dcpt_entry_t ways[DCPT_WAYS];
+} __attribute__((aligned(64)));
+
+/* The table of one prefetcher instance */
+struct dcpt_table_t
+{
+    dcpt_set_t sets[DCPT_SETS];
+};
+
+dcpt_set_t& dcpt_set(dcpt_table_t& dcpt, Addr pc)
+{
+    Addr index = pc >> 2;
+    return dcpt.sets[(index ^ (index / DCPT_SETS)) % DCPT_SETS];
+}
+
+void dcpt_touch(dcpt_set_t& set, dcpt_entry_t* entry)
+{
+    for (int i = 0; i < DCPT_WAYS; ++i)
+        if (set.ways[i].lru < entry->lru) ++set.ways[i].lru;
+
+    entry->lru = 0;
+}
+
+/* Returns the entry of the instruction, replacing the least recently used
+   entry of its set if it is not in the table. `found` tells which one. */
+dcpt_entry_t* dcpt_lookup(dcpt_table_t& dcpt, Addr pc, bool& found)
+{
+    dcpt_set_t& set = dcpt_set(dcpt, pc);
+    dcpt_entry_t* entry = NULL;
+    dcpt_entry_t* victim = &set.ways[0];
+
+    for (int i = 0; i < DCPT_WAYS; ++i)
+    {
+        dcpt_entry_t& way = set.ways[i];
+
+        if (way.valid && way.pc == pc) { entry = &way; break; }
+
+        if (way.lru > victim->lru || (!way.valid && victim->valid))
+            victim = &way;
+    }
+
+    found = (entry != NULL);
+    if (!found)
+    {
+        entry = victim;
+
+        entry->pc = pc;
+        entry->last_addr = 0;
+        entry->last_pf_addr = 0;
+        entry->delta_head = 0;
+        entry->delta_count = 0;
+        entry->valid = 1;
+    }
+
+    dcpt_touch(set, entry);
+    return entry;
+}
+
+/* The i-th delta, 0 being the oldest one still in the buffer */
+int dcpt_delta(const dcpt_entry_t& entry, int i)
+{
+    int pos = entry.delta_head - entry.delta_count + i;
+    return entry.deltas[(pos + NUM_DELTAS) % NUM_DELTAS];
+}
+
+void dcpt_add_delta(dcpt_entry_t& entry, int64_t delta)
+{
+    if (delta > MAX_DELTA || delta < -MAX_DELTA) delta = 0;
+
+    entry.deltas[entry.delta_head] = (int16_t)delta;
+    entry.delta_head = (entry.delta_head + 1) % NUM_DELTAS;
+    if (entry.delta_count < NUM_DELTAS) ++entry.delta_count;
+}
+
+/* Looks for the last pair of deltas earlier in the buffer and replays the
+   deltas which followed it. Returns the number of candidates. */
+int dcpt_correlate(const dcpt_entry_t& entry, Addr* candidates)
+{
+    int count = entry.delta_count;
+    if (count < 3) return 0;
+
+    int d1 = dcpt_delta(entry, count - 2);
+    int d2 = dcpt_delta(entry, count - 1);
+    if (d1 == 0 || d2 == 0) return 0;
+
+    for (int i = 0; i + 2 < count; ++i)
+    {
+        if (dcpt_delta(entry, i) != d1 || dcpt_delta(entry, i + 1) != d2)
+            continue;
+
+        /* Pattern found, the deltas after it are the predicted ones */
+        int num = 0;
+        Addr addr = entry.last_addr;
+
+        for (int j = i + 2; j < count; ++j)
+        {
+            int delta = dcpt_delta(entry, j);
+            if (delta == 0) break;
+
+            addr += (int64_t)delta * BLOCK_SIZE;
+            candidates[num++] = addr;
+        }
+
+        return num;
+    }
+
+    return 0;
+}
+
+template <class Sink>
+void dcpt_prefetch(dcpt_entry_t& entry, Sink& sink)
+{
+    Addr candidates[NUM_DELTAS];
+    int num = dcpt_correlate(entry, candidates);
+
+    /* Skips the candidates which have already been prefetched */
+    int first = 0;
+    for (int i = 0; i < num; ++i)
+        if (candidates[i] == entry.last_pf_addr) first = i + 1;
+
+    int last = first + sink.Degree(MAX_DEGREE);
+    if (last > num) last = num;
+
+    for (int i = first; i < last; ++i)
+    {
+        Addr pf_addr = candidates[i];
+
+        if (pf_addr > MAX_PHYS_MEM_ADDR) break;
+
+        /* The nearest ones are needed first */
+        LOGD("push_prefetch: addr = 0x%016x, pc=0x%016x, "
+             "current_queue_size = %d",
+             pf_addr, entry.pc, current_queue_size());
+        sink.Push(pf_addr, last - i);
+
+        entry.last_pf_addr = pf_addr;
+    }
+}
+
+/* ----------------------------------------------------------------- Stages */
+class DcptTrainer : public TrainerBase
+{
+private:
+    dcpt_table_t mTable;
+
+public:
+    dcpt_entry_t* Entry; /* Entry to predict from, NULL if none */
+
+    void Init()
+    {
+        memset(&mTable, 0, sizeof(mTable));
+        for (int i = 0; i < DCPT_SETS; ++i)
+            for (int j = 0; j < DCPT_WAYS; ++j)
+                mTable.sets[i].ways[j].lru = DCPT_WAYS - 1;
+
+        Entry = NULL;
+    }
+
+    void Train(const AccessStat& stat, Addr addr)
+    {
+        bool found;
+        dcpt_entry_t* entry = dcpt_lookup(mTable, stat.pc, found);
+        Entry = NULL;
+
+        if (!found)
+        {
+            entry->last_addr = addr;
+            return;
+        }
+
+        int64_t delta = ((int64_t)addr - (int64_t)entry->last_addr) / BLOCK_SIZE;
+        if (delta == 0) return;
+
+        dcpt_add_delta(*entry, delta);
+        entry->last_addr = addr;
+        Entry = entry;
+    }
+
+    double Occupancy() const
+    {
+        int valid = 0;
+
+        for (int i = 0; i < DCPT_SETS; ++i)
+            for (int j = 0; j < DCPT_WAYS; ++j)
+                valid += mTable.sets[i].ways[j].valid;
+
+        return (double)valid / DCPT_ENTRIES;
+    }
+};
+
+class DcptPredictor
+{
+public:
+    void Init() { }
+
+    template <class Sink>
+    void Predict(const AccessStat& stat, Addr addr, DcptTrainer& trainer,
+                 Sink& sink)
+    {
+        if (trainer.Entry != NULL) dcpt_prefetch(*trainer.Entry, sink);
+    }
+};
+
+typedef PrefetchPipeline<DcptTrainer, DcptPredictor> Prefetcher;
+
+PrefetcherInstances<Prefetcher> prefetchers;
+
+/* --------------------------------- Standard hardware prefetcher interface */
+void prefetch_init(void)
+{
+    LOGD("prefetch_init");
+
+    prefetchers.Current().Init();
+}
+
+void prefetch_access(AccessStat stat)
+{
+    LOG_SET_TIME(stat.time);
+
+    LOGD("prefetch_access: addr = 0x%016x, pc = 0x%016x, miss = %d",
+         stat.mem_addr, stat.pc, stat.miss);
+
+    prefetchers.Current().Access(stat);
+}
+
+void prefetch_complete(Addr addr)
+{
+    LOGD("prefetch_complete: addr = 0x%016x, current_queue_size = %d",
+         addr, current_queue_size());
+
+    prefetchers.Current().Complete(addr);
+}
+
+void prefetch_final(void)
+{
+    Prefetcher& prefetcher = prefetchers.Current();
+
+    prefetcher.Print(stderr, "dcpt");
+    LOG_EVENT_DUMP();
+}
+
+/* Only called by the benchmarks */
+double prefetch_occupancy(void)
+{
+    return prefetchers.Current().Occupancy();
+}
+
+/* Only called by the simulator, same as prefetch_access on every access */
+void prefetch_access_batch(const AccessBatch& batch, AccessDemand demand,
+                           void* context)
+{
+    prefetchers.Current().Access(batch, demand, context);
+}
+
+/* Only called by the simulator, which creates an instance per cache */
+PREFETCH_INSTANCE_FUNCTIONS(prefetchers)
@@ -5,98 +5,77 @@
  *
  * Unauthorized copying of this file, via any medium is strictly prohibited
  * Proprietary and confidential
+ *
+ * Build with -DGROUPED_HISTORY_COMPACT to store the history with 32-bit
+ * addresses and 16-bit deltas, which fits half as many entries again in the
+ * same memory.
  */
 
 #include "interface.hh"
 
-typedef int64_t DAddr;
-#define MAX_HISTORY (2 * 1024)
-
 /* ---------------------------------------------------------------- Logging */
-#include <cstdio>
-#include <cstdarg>
-
-#define LOGD(...) PrintLog(__PRETTY_FUNCTION__, "DEBUG", __VA_ARGS__)
-#define LOGE(...) PrintLog(__PRETTY_FUNCTION__, "ERROR", __VA_ARGS__)
-#define LOG(...) LOGD(__VA_ARGS__)
-
-void PrintLog(const char* func, const char* tag, const char* format, ...)
-{
-    static char buffer[1000];
-
-    int len = sprintf(buffer, "%s ", tag);
-
-    va_list args;
-    va_start(args, format);
-    len += vsprintf(&buffer[len], format, args);
-    va_end(args);
+#include "prefetch_log.hh"
 
-    sprintf(&buffer[len], " (%s)\n", func);
+/* --------------------------------------------------------------- Pipeline */
+#include "prefetch_pipeline.hh"
+#include "prefetch_instances.hh"
+#include "stage_grouped_history.hh"
 
-    DPRINTF(HWPrefetch, "%s", buffer);
-}
-
-/* ---------------------------------------------------------------- History */
-#include "grouped_history.hh"
+typedef PrefetchPipeline<GroupedHistoryTrainer, ChainPredictor> Prefetcher;
 
-class Callbacks : public GroupedHistoryCallbacks<DAddr>
-{
-public:
-    virtual bool CanMerge(const GroupedHistoryEntry<DAddr>& a,
-                          const GroupedHistoryEntry<DAddr>& b)
-    {
-        //return false;
-        if (a.Data != b.Data) return false;
-        if (a.LastAddr + BLOCK_SIZE < b.FirstAddr) return false;
-        return true;
-    }
-};
-
-Callbacks historyCallbacks;
-GroupedHistory<DAddr> history(historyCallbacks, BLOCK_SIZE, MAX_HISTORY);
+PrefetcherInstances<Prefetcher> prefetchers;
 
 /* --------------------------------- Standard hardware prefetcher interface */
-Addr prev_addr;
-
 void prefetch_init(void)
 {
     LOGD("prefetch_init");
-    prev_addr = 0;
+
+    prefetchers.Current().Init();
 }
 
 void prefetch_access(AccessStat stat)
 {
+    LOG_SET_TIME(stat.time);
+
     LOGD("prefetch_access: addr = 0x%016x, pc = 0x%016x, miss = %d",
          stat.mem_addr, stat.pc, stat.miss);
 
-    Addr addr = stat.mem_addr & ~((Addr)(BLOCK_SIZE - 1));
-if (stat.miss)
+    prefetchers.Current().Access(stat);
+}
+
+void prefetch_complete(Addr addr)
 {
-    if (prev_addr != 0)
-    {
-        DAddr delta = (DAddr)addr - (DAddr)prev_addr;
-        history.Update(stat.time, prev_addr, delta);
-        LOGD("history_update: time = %d, addr = 0x%016x, delta = %d", stat.time, prev_addr, delta);
-    }
-
-    if (prev_addr != addr) prev_addr = addr;
+    LOGD("prefetch_complete: addr = 0x%016x, current_queue_size = %d",
+         addr, current_queue_size());
+
+    prefetchers.Current().Complete(addr);
 }
 
-    if (stat.miss)
-    {
-        Addr pf_addr = addr + BLOCK_SIZE;
+void prefetch_final(void)
+{
+    Prefetcher& prefetcher = prefetchers.Current();
 
-        GroupedHistoryEntry<DAddr>* entry = history.Get(addr);
-        if (entry != NULL && addr + entry->Data > 0 && addr + entry->Data <= MAX_PHYS_MEM_ADDR)
-            pf_addr = addr + entry->Data;
+#ifdef GROUPED_HISTORY_COMPACT
+    fprintf(stderr, "joseph97-with-grouped-history: %llu deltas too far for the compact table\n",
+            (unsigned long long)prefetcher.GetTrainer().Dropped());
+#endif /* GROUPED_HISTORY_COMPACT */
 
-        if (!in_cache(pf_addr))
-            issue_prefetch(pf_addr);
-    }
+    prefetcher.Print(stderr, "joseph97-with-grouped-history");
+    LOG_EVENT_DUMP();
 }
 
-void prefetch_complete(Addr addr)
+/* Only called by the benchmarks */
+double prefetch_occupancy(void)
 {
-    LOGD("prefetch_complete: addr = 0x%016x, current_queue_size = %d",
-         addr, current_queue_size());
+    return prefetchers.Current().Occupancy();
+}
+
+/* Only called by the simulator, same as prefetch_access on every access */
+void prefetch_access_batch(const AccessBatch& batch, AccessDemand demand,
+                           void* context)
+{
+    prefetchers.Current().Access(batch, demand, context);
 }
+
+/* Only called by the simulator, which creates an instance per cache */
+PREFETCH_INSTANCE_FUNCTIONS(prefetchers)
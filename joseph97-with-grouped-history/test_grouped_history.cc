@@ -8,6 +8,7 @@
  */
 
 #include <iostream>
+#include <vector>
 #include <stdint.h>
 
 #include "grouped_history.hh"
@@ -22,6 +23,62 @@ public:
 
 Callbacks historyCallbacks;
 GroupedHistory<int> history(historyCallbacks, 1, 2);
+GroupedHistory<int> rangeHistory(historyCallbacks, 1, 8);
+
+/* Records the entries visited, and stops after the first limit ones */
+class Collector
+{
+public:
+    std::vector<GroupedHistoryEntry<int> > Entries;
+    size_t Limit;
+
+    Collector(size_t limit) : Limit(limit) { }
+
+    bool operator()(const GroupedHistoryEntry<int>& entry)
+    {
+        Entries.push_back(entry);
+        return Entries.size() < Limit;
+    }
+};
+
+/* Expected [FirstAddr, LastAddr, Data] triples, in address order */
+struct Interval
+{
+    ADDR FirstAddr;
+    ADDR LastAddr;
+    int Data;
+};
+
+bool check_range(ADDR firstAddr, ADDR lastAddr, size_t limit,
+                 const Interval* expected, int count)
+{
+    Collector collector(limit);
+    int visited = rangeHistory.GetRange(firstAddr, lastAddr, collector);
+    bool ok = (visited == count && (int)collector.Entries.size() == count);
+
+    for (int i = 0; ok && i < count; ++i)
+    {
+        const GroupedHistoryEntry<int>& entry = collector.Entries[i];
+        ok = (entry.FirstAddr == expected[i].FirstAddr &&
+              entry.LastAddr == expected[i].LastAddr &&
+              entry.Data == expected[i].Data);
+    }
+
+    std::cout << "Range [" << firstAddr << ", " << lastAddr << "]"
+              << std::endl;
+
+    for (size_t i = 0; i < collector.Entries.size(); ++i)
+    {
+        const GroupedHistoryEntry<int>& entry = collector.Entries[i];
+        std::cout << "[" << entry.FirstAddr << ", " << entry.LastAddr
+                  << "] data = " << entry.Data << std::endl;
+    }
+
+    if (!ok) std::cerr << "GetRange(" << firstAddr << ", " << lastAddr
+                       << ") mismatch" << std::endl;
+    return ok;
+}
+
 
 int main()
 {
@@ -32,5 +89,27 @@ int main()
     history.Update(4, 6, 1); history.Print();
     history.Update(5, 6, 0); history.Print();
 
-    return 0;
+    rangeHistory.Update(0, 10, 1);
+    rangeHistory.Update(1, 12, 2);
+    rangeHistory.Update(2, 20, 1);
+    rangeHistory.Update(3, 21, 1);
+    rangeHistory.Update(4, 30, 3);
+
+    static const Interval middle[] = { { 12, 12, 2 }, { 20, 21, 1 } };
+    static const Interval inside[] = { { 20, 21, 1 }, { 30, 30, 3 } };
+    static const Interval all[] = {
+        { 10, 10, 1 }, { 12, 12, 2 }, { 20, 21, 1 }, { 30, 30, 3 } };
+
+    bool ok = true;
+
+    ok = check_range(11, 25, 8, middle, 2) && ok;
+    ok = check_range(21, 30, 8, inside, 2) && ok;
+    ok = check_range(0, 100, 8, all, 4) && ok;
+    ok = check_range(13, 19, 8, NULL, 0) && ok;
+
+    /* The visitor stops the query */
+    ok = check_range(0, 100, 1, all, 1) && ok;
+    ok = check_range(11, 30, 2, middle, 2) && ok;
+
+    return ok ? 0 : 1;
 }
@@ -10,148 +10,82 @@
  *   Doug Joseph and Dirk Grunwald, "Prefetching using Markov Predictors",
  *     Preceedings of the 24th Annual International Symposium on Computer
  *     Architecture (ISCA '97), p. 252-263, June 1997, Denver, Colorado, USA
+ *
+ * Every successor of a node has a saturating confidence counter. On a miss
+ * up to MARKOV_DEGREE successors are prefetched in order of confidence,
+ * which is also their priority when they have to wait for the prefetch
+ * queue. The degree is lowered by the feedback while the prefetches are not
+ * useful.
+ *
+ * Build with -DMARKOV_COMPACT to store the nodes with 16-bit successor
+ * deltas, which fits twice the history in less memory.
  */
 
 #include "interface.hh"
 
-#include <deque>
-#include <queue>
-#include <algorithm>
-#include <map>
+/* ---------------------------------------------------------------- Logging */
+#include "prefetch_log.hh"
 
-#include <cstdio>
-#include <cstdarg>
+/* --------------------------------------------------------------- Pipeline */
+#include "prefetch_pipeline.hh"
+#include "prefetch_instances.hh"
+#include "stage_markov.hh"
 
-#define MAX_NODE   32768
-#define MAX_FANOUT 4
+typedef PrefetchPipeline<MarkovTrainer, MarkovPredictor> Prefetcher;
 
-/* ---------------------------------------------------------------- Logging */
-#define LOGD(...) PrintLog(__PRETTY_FUNCTION__, __VA_ARGS__)
+PrefetcherInstances<Prefetcher> prefetchers;
 
-void PrintLog(const char* func, const char* format, ...)
+/* --------------------------------- Standard hardware prefetcher interface */
+void prefetch_init(void)
 {
-    static char buffer[1000];
-
-    int len = sprintf(buffer, "DEBUG ");
-    
-    va_list args;
-    va_start(args, format);
-    len += vsprintf(&buffer[len], format, args);
-    va_end(args);
+    LOGD("prefetch_init");
 
-    sprintf(&buffer[len], " (%s)\n", func);
-
-    DPRINTF(HWPrefetch, "%s", buffer);
+    prefetchers.Current().Init();
 }
 
-/* ------------------------------------------------------ Markov-like model */
-struct node_t
+void prefetch_access(AccessStat stat)
 {
-    Addr addr;
-    int count; /* Count in history */
-    std::deque<Addr> next_misses;
-};
+    LOG_SET_TIME(stat.time);
 
-std::queue<Addr> miss_history;
-std::map<Addr, node_t> nodes;
+    LOGD("prefetch_access: addr = 0x%016x, pc = 0x%016x, miss = %d",
+         stat.mem_addr, stat.pc, stat.miss);
 
-void model_add_miss(Addr addr)
-{
-    Addr last_miss_addr = (miss_history.size() > 0) ? miss_history.back() : 0;
-    
-    /* Removes the outdated history entry */
-    if (miss_history.size() == MAX_NODE)
-    {
-        Addr outdated_addr = miss_history.front();
-        node_t& node = nodes[outdated_addr];
-
-        /* If this is the last entry, remove it from the model */
-        --node.count;
-        if (node.count == 0)
-            nodes.erase(outdated_addr);
-
-        /* Removes the history entry */
-        miss_history.pop();
-    }
-
-    /* Adds new miss access to history */
-    miss_history.push(addr);
-
-    /* Creates new model node if it does not exist and increases the count */
-    if (nodes.find(addr) == nodes.end())
-    {
-        node_t node;
-        node.addr = addr;
-        node.count = 1;
-
-        nodes[addr] = node;
-    }
-    else ++nodes[addr].count;
-
-    /* Adds the new address to the top of the last miss address prediction */
-    if (last_miss_addr != 0)
-    {
-        LOGD("addr: 0x%016x, last_miss_addr: 0x%016x", addr, last_miss_addr);
-        node_t& last_node = nodes[last_miss_addr];
-        std::deque<Addr>& next_misses = last_node.next_misses;
-
-        {
-            std::deque<Addr>::iterator it = std::find(
-                next_misses.begin(), next_misses.end(), addr);
-            if (it != next_misses.end())
-                next_misses.erase(it);
-            if (next_misses.size() == MAX_FANOUT)
-                next_misses.pop_front();
-        }
-
-        next_misses.push_back(addr);
-        if (nodes[last_miss_addr].next_misses.size() != next_misses.size())
-            LOGD("ERROR");
-        else LOGD("last_miss_node.next_misses.size = %d", next_misses.size());
-    }
+    prefetchers.Current().Access(stat);
 }
 
-void model_prefetch(Addr addr)
+void prefetch_complete(Addr addr)
 {
-    std::map<Addr, node_t>::iterator it = nodes.find(addr);
-    if (it == nodes.end()) return;
-    node_t& node = it->second;
-
-    LOGD("model_prefetch: addr = 0x%016x, node_count = %d, predict_count = %d",
-         addr, nodes.size(), node.next_misses.size());
-    if (node.next_misses.size() > 0)
-    {
-        Addr pf_addr = node.next_misses.back();
-        if (!in_cache(pf_addr) && !in_mshr_queue(pf_addr))
-        {
-            LOGD("issue_prefetch: addr = 0x%016x", addr);
-            issue_prefetch(pf_addr);
-        }
-    }
+    LOGD("prefetch_complete: addr = 0x%016x, current_queue_size = %d",
+         addr, current_queue_size());
+
+    prefetchers.Current().Complete(addr);
 }
 
-/* ------------------------------------------ Prefetcher standard interface */
-void prefetch_init(void)
+void prefetch_final(void)
 {
+    Prefetcher& prefetcher = prefetchers.Current();
+
+#ifdef MARKOV_COMPACT
+    fprintf(stderr, "joseph97: %llu transitions too far for the compact table\n",
+            (unsigned long long)prefetcher.GetTrainer().Dropped());
+#endif /* MARKOV_COMPACT */
+
+    prefetcher.Print(stderr, "joseph97");
+    LOG_EVENT_DUMP();
 }
 
-void prefetch_access(AccessStat stat)
+/* Only called by the benchmarks */
+double prefetch_occupancy(void)
 {
-    Addr addr = stat.mem_addr;
-    addr &= ~(Addr)(BLOCK_SIZE - 1);
-
-    LOGD("prefetch_access: addr = 0x%016x, miss = %d, current_queue_size = %d",
-         addr, stat.miss, current_queue_size());
-    
-    if (stat.miss)
-    {
-        model_add_miss(addr);
-        model_prefetch(addr);
-    }
+    return prefetchers.Current().Occupancy();
 }
 
-void prefetch_complete(Addr addr)
+/* Only called by the simulator, same as prefetch_access on every access */
+void prefetch_access_batch(const AccessBatch& batch, AccessDemand demand,
+                           void* context)
 {
-    LOGD("prefetch_complete: addr = 0x%016x, current_queue_size = %d",
-         addr, current_queue_size());
+    prefetchers.Current().Access(batch, demand, context);
 }
+
+/* Only called by the simulator, which creates an instance per cache */
+PREFETCH_INSTANCE_FUNCTIONS(prefetchers)
@@ -11,53 +11,65 @@
 
 #include "interface.hh"
 
-#include <cstdio>
-#include <cstdarg>
-
 /* ---------------------------------------------------------------- Logging */
-#define LOGD(...) PrintLog(__PRETTY_FUNCTION__, __VA_ARGS__)
+#include "prefetch_log.hh"
 
-void PrintLog(const char* func, const char* format, ...)
-{
-    static char buffer[1000];
+/* --------------------------------------------------------------- Pipeline */
+#include "prefetch_pipeline.hh"
+#include "prefetch_instances.hh"
+#include "stage_next_line.hh"
 
-    int len = sprintf(buffer, "DEBUG ");
-    
-    va_list args;
-    va_start(args, format);
-    len += vsprintf(&buffer[len], format, args);
-    va_end(args);
+typedef PrefetchPipeline<NullTrainer, NextLinePredictor> Prefetcher;
 
-    sprintf(&buffer[len], " (%s)\n", func);
-
-    DPRINTF(HWPrefetch, "%s", buffer);
-}
+/* Starts as a plain one block lookahead */
+PrefetcherInstances<Prefetcher> prefetchers(1);
 
 /* --------------------------------- Standard hardware prefetcher interface */
 void prefetch_init(void)
 {
     LOGD("prefetch_init");
+
+    prefetchers.Current().Init();
 }
 
 void prefetch_access(AccessStat stat)
 {
+    LOG_SET_TIME(stat.time);
+
     LOGD("prefetch_access: addr = 0x%016x, pc = 0x%016x, miss = %d",
          stat.mem_addr, stat.pc, stat.miss);
 
-    Addr pf_addr = stat.mem_addr + BLOCK_SIZE;
-    pf_addr &= ~(Addr)(BLOCK_SIZE - 1);
-
-    if (stat.miss && !in_cache(pf_addr))
-    {
-        LOGD("issue_prefetch: addr = 0x%016x, pc=0x%016x, "
-             "current_queue_size = %d",
-             pf_addr, stat.pc, current_queue_size());
-        issue_prefetch(pf_addr);
-    }
+    prefetchers.Current().Access(stat);
 }
 
 void prefetch_complete(Addr addr)
 {
     LOGD("prefetch_complete: addr = 0x%016x, current_queue_size = %d",
          addr, current_queue_size());
+
+    prefetchers.Current().Complete(addr);
 }
+
+void prefetch_final(void)
+{
+    Prefetcher& prefetcher = prefetchers.Current();
+
+    prefetcher.Print(stderr, "one-block-lookahead");
+    LOG_EVENT_DUMP();
+}
+
+/* Only called by the benchmarks */
+double prefetch_occupancy(void)
+{
+    return prefetchers.Current().Occupancy();
+}
+
+/* Only called by the simulator, same as prefetch_access on every access */
+void prefetch_access_batch(const AccessBatch& batch, AccessDemand demand,
+                           void* context)
+{
+    prefetchers.Current().Access(batch, demand, context);
+}
+
+/* Only called by the simulator, which creates an instance per cache */
+PREFETCH_INSTANCE_FUNCTIONS(prefetchers)
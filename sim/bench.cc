@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Microbenchmark of the prefetcher linked with it. Synthetic workloads and
+ * recorded traces are replayed through the simulator core, once with the
+ * cache model alone and once with the prefetcher, and the difference is
+ * the cost of the prefetcher: its calls and the cache functions it calls.
+ */
+
+#include "simulator.hh"
+#include "bench_common.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <unistd.h>
+
+/* ---------------------------------------------------------- Configuration */
+struct BenchConfig
+{
+    int Accesses;    /* Accesses of every synthetic workload */
+    int Repetitions; /* The fastest replay is kept */
+    int Batched;     /* Replays through prefetch_access_batch */
+};
+
+static BenchConfig bench = { 1000000, 3, 0 };
+
+/* ---------------------------------------------------------- Measurements */
+struct BenchResult
+{
+    uint64_t Accesses;
+    double NsPerAccess;
+    double AllocsPerAccess;
+    long RssKb;      /* Growth of the resident set during the replays */
+    long PeakRssKb;  /* Peak of that growth */
+    double Occupancy;
+    double Accuracy;
+    double Coverage;
+};
+
+/* Replays the workload, returns its duration and counts its allocations */
+static double replay(const Workload& work, int baseline, uint64_t& allocs,
+                     SimStats& stats)
+{
+    config.Baseline = baseline;
+    sim_start();
+
+    uint64_t before = allocations;
+    double start = now_ns();
+
+    if (bench.Batched)
+        sim_access_batch(&work[0], (int)work.size());
+    else
+    {
+        for (size_t i = 0; i < work.size(); ++i)
+            sim_access(work[i]);
+    }
+
+    sim_finish(stats);
+
+    double time = now_ns() - start;
+    allocs = allocations - before;
+
+    return time;
+}
+
+static void measure(const Workload& work, BenchResult& result)
+{
+    long rss = rss_kb();
+    reset_peak_rss();
+    double baseTime = 0, time = 0;
+    uint64_t baseAllocs = 0, allocs = 0;
+    SimStats stats;
+
+    for (int i = 0; i < bench.Repetitions; ++i)
+    {
+        double t = replay(work, 1, baseAllocs, stats);
+        if (i == 0 || t < baseTime) baseTime = t;
+
+        t = replay(work, 0, allocs, stats);
+        if (i == 0 || t < time) time = t;
+    }
+
+    double n = (work.size() > 0) ? (double)work.size() : 1.0;
+    double excess = (allocs > baseAllocs) ? (double)(allocs - baseAllocs) : 0;
+
+    result.Accesses = work.size();
+    result.NsPerAccess = (time > baseTime) ? (time - baseTime) / n : 0.0;
+    result.AllocsPerAccess = excess / n;
+    result.Occupancy = prefetch_occupancy ? prefetch_occupancy() : -1;
+
+    result.Accuracy = (stats.Issued > 0)
+        ? (double)stats.Useful / stats.Issued : 0.0;
+    result.Coverage = (stats.Useful + stats.Misses > 0)
+        ? (double)stats.Useful / (stats.Useful + stats.Misses) : 0.0;
+
+    result.RssKb = rss_kb() - rss;
+    result.PeakRssKb = peak_rss_kb() - rss;
+
+    sim_stop();
+}
+
+/* ----------------------------------------------------------------- Report */
+/* The prefetcher name is taken from the binary name (bench-<name>) */
+static std::string prefetcher_name(const char* prog)
+{
+    std::string name = test_name(prog);
+    if (name.compare(0, 6, "bench-") == 0) name = name.substr(6);
+    return name;
+}
+
+static void print_header(const std::string& prefetcher)
+{
+    printf("                           BENCHMARK: %s%s\n", prefetcher.c_str(),
+           bench.Batched ? " (batched)" : "");
+    printf("--------------------------------------------------------------------------\n");
+    printf("       TEST      ACCESSES  NS/ACC ALLOC/ACC  RSS KiB PEAK KiB  OCC  ACC  COV\n");
+    printf("--------------------------------------------------------------------------\n");
+}
+
+static void print_row(const std::string& name, const BenchResult& r)
+{
+    char occupancy[8] = "   -";
+    if (r.Occupancy >= 0)
+        snprintf(occupancy, sizeof(occupancy), "%4.2f", r.Occupancy);
+
+    printf(" %-13s %10llu %7.1f %9.4f %8ld %8ld %s %4.2f %4.2f\n",
+           name.c_str(), (unsigned long long)r.Accesses, r.NsPerAccess,
+           r.AllocsPerAccess, r.RssKb, r.PeakRssKb, occupancy, r.Accuracy,
+           r.Coverage);
+}
+
+static void print_footer()
+{
+    printf("--------------------------------------------------------------------------\n");
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] [trace...]\n"
+            "  -n <count>  accesses of every synthetic workload (default %d)\n"
+            "  -r <count>  replays of every workload, the fastest is kept\n"
+            "              (default %d)\n"
+            "  -s <KiB>    L2 size (default %d)\n"
+            "  -i <ticks>  minimum interval between two completions (default %lld)\n"
+            "  -b          replays in batches, through prefetch_access_batch if\n"
+            "              the prefetcher provides it\n"
+            "The synthetic workloads are stride, multi-stride, pointer-chase and\n"
+            "random; traces are replayed after them.\n",
+            prog, bench.Accesses, bench.Repetitions, config.CacheSize / 1024,
+            (long long)config.Interval);
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:s:i:bh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': bench.Accesses = atoi(optarg); break;
+        case 'r': bench.Repetitions = atoi(optarg); break;
+        case 's': config.CacheSize = atoi(optarg) * 1024; break;
+        case 'i': config.Interval = atoll(optarg); break;
+        case 'b': bench.Batched = 1; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (bench.Accesses <= 0 || bench.Repetitions <= 0 || config.CacheSize <= 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int failed = 0;
+    int count = NUM_SYNTHETIC_WORKLOADS + argc - optind;
+
+    print_header(prefetcher_name(argv[0]));
+
+    for (int i = 0; i < count; ++i)
+    {
+        const char* name = (i < NUM_SYNTHETIC_WORKLOADS)
+            ? synthetic_workloads[i]
+            : argv[optind + i - NUM_SYNTHETIC_WORKLOADS];
+        BenchResult result;
+
+        if (run_isolated(name, bench.Accesses, measure, result) != 0)
+        {
+            fprintf(stderr, "Failed to benchmark %s\n", name);
+            failed = 1;
+            continue;
+        }
+
+        print_row(test_name(name), result);
+    }
+
+    print_footer();
+
+    return failed;
+}
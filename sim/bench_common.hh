@@ -0,0 +1,298 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Workloads and measurements shared by the benchmarks. It replaces the
+ * global operator new to count the allocations, so it must be included by
+ * a single translation unit of every benchmark.
+ *
+ * Every workload is built and measured in a forked child process, so that
+ * the resident set and the state measured are its own.
+ */
+
+#pragma once
+
+#include "interface.hh"
+#include "trace_format.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/* ------------------------------------------------------------ Allocations */
+static uint64_t allocations = 0;
+
+void* operator new(size_t size)
+{
+    ++allocations;
+
+    void* ptr = malloc(size > 0 ? size : 1);
+    if (ptr == NULL) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) throw()
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) throw()
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t size) throw()
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t size) throw()
+{
+    free(ptr);
+}
+
+/* -------------------------------------------------------------- Workloads */
+typedef std::vector<TraceRecord> Workload;
+
+/* Deterministic, so that every run replays the same workloads */
+static uint64_t random_state;
+
+static uint64_t next_random()
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+static void add_access(Workload& work, uint64_t pc, uint64_t addr)
+{
+    TraceRecord rec;
+    rec.Pc = pc;
+    rec.Addr = addr & MAX_PHYS_MEM_ADDR;
+    rec.Time = (int64_t)work.size() * 50;
+    rec.Miss = 0;
+    work.push_back(rec);
+}
+
+/* One instruction walking memory with a stride of two blocks */
+static void gen_stride(Workload& work, int n)
+{
+    for (int i = 0; i < n; ++i)
+        add_access(work, 0x400100, 0x100000 + (uint64_t)i * 2 * BLOCK_SIZE);
+}
+
+/* Eight instructions with strides of 1 to 8 blocks, interleaved */
+static void gen_multi_stride(Workload& work, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        int s = i % 8;
+        uint64_t base = 0x1000000 + (uint64_t)s * 0x1000000;
+        add_access(work, 0x400200 + s * 4,
+                   base + (uint64_t)(i / 8) * (s + 1) * BLOCK_SIZE);
+    }
+}
+
+/* A linked list of 32768 blocks in random order, traversed again and
+   again, twice as large as the L2 */
+static void gen_pointer_chase(Workload& work, int n)
+{
+    const int nodes = 32768;
+    std::vector<int> next(nodes);
+
+    /* Sattolo's algorithm, a single cycle through all the nodes */
+    for (int i = 0; i < nodes; ++i) next[i] = i;
+    for (int i = nodes - 1; i > 0; --i)
+    {
+        int j = (int)(next_random() % i);
+        int tmp = next[i]; next[i] = next[j]; next[j] = tmp;
+    }
+
+    for (int i = 0, node = 0; i < n; ++i, node = next[node])
+        add_access(work, 0x400300, 0x2000000 + (uint64_t)node * BLOCK_SIZE);
+}
+
+/* Sixteen instructions accessing random blocks of 64 MiB */
+static void gen_random(Workload& work, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        uint64_t r = next_random();
+        add_access(work, 0x400400 + (r % 16) * 4,
+                   0x4000000 + ((r >> 8) % (1 << 20)) * BLOCK_SIZE);
+    }
+}
+
+static bool load_trace(Workload& work, const char* path)
+{
+    TraceReader reader;
+    if (!reader.Open(path)) return false;
+
+    TraceRecord rec;
+    while (reader.Next(rec)) work.push_back(rec);
+
+    return true;
+}
+
+static const char* const synthetic_workloads[] =
+    { "stride", "multi-stride", "pointer-chase", "random" };
+
+#define NUM_SYNTHETIC_WORKLOADS 4
+
+/* Generates the synthetic workload of this name with n accesses, or loads
+   the trace of this path */
+static bool make_workload(Workload& work, const char* name, int n)
+{
+    random_state = 88172645463325252ULL;
+
+    if (strcmp(name, "stride") == 0) gen_stride(work, n);
+    else if (strcmp(name, "multi-stride") == 0) gen_multi_stride(work, n);
+    else if (strcmp(name, "pointer-chase") == 0) gen_pointer_chase(work, n);
+    else if (strcmp(name, "random") == 0) gen_random(work, n);
+    else return load_trace(work, name);
+
+    return true;
+}
+
+/* ------------------------------------------------------------------ Timing */
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Peak resident set since the last reset_peak_rss() */
+static long peak_rss_kb()
+{
+    FILE* file = fopen("/proc/self/status", "r");
+
+    if (file != NULL)
+    {
+        char line[256];
+        long peak = -1;
+
+        while (peak < 0 && fgets(line, sizeof(line), file) != NULL)
+            if (sscanf(line, "VmHWM: %ld", &peak) != 1) peak = -1;
+
+        fclose(file);
+        if (peak >= 0) return peak;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/* Starts the peak resident set over from the current one, so that building
+   the workload does not count. Only Linux allows it. */
+static void reset_peak_rss()
+{
+    FILE* file = fopen("/proc/self/clear_refs", "w");
+    if (file == NULL) return;
+
+    fputs("5", file);
+    fclose(file);
+}
+
+/* Current resident set, which grows as the tables are first touched */
+static long rss_kb()
+{
+    long pages = 0, resident = 0;
+
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (file == NULL) return 0;
+
+    if (fscanf(file, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(file);
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* ---------------------------------------------------------------- Process */
+/* Builds the workload of this name with n accesses and measures it in a
+   child process */
+template <class Result>
+static int run_isolated(const char* name, int n,
+                        void (*measure)(const Workload&, Result&),
+                        Result& result)
+{
+    int fds[2];
+    if (pipe(fds) != 0) return 1;
+
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid < 0) return 1;
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+
+        Workload work;
+        int ret = 0;
+
+        if (!make_workload(work, name, n))
+        {
+            fprintf(stderr, "Cannot open trace %s\n", name);
+            ret = 1;
+        }
+
+        if (ret == 0)
+        {
+            measure(work, result);
+            if (write(fds[1], &result, sizeof(result)) != sizeof(result))
+                ret = 1;
+        }
+
+        close(fds[1]);
+        fflush(stdout);
+        _exit(ret);
+    }
+
+    close(fds[1]);
+    ssize_t len = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    if (len != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return 1;
+
+    return 0;
+}
+
+/* ----------------------------------------------------------------- Report */
+/* Name of a workload, the base name of a trace without its extension */
+static std::string test_name(const char* path)
+{
+    std::string name(path);
+
+    size_t slash = name.find_last_of('/');
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+
+    size_t dot = name.find('.');
+    if (dot != std::string::npos && dot > 0) name = name.substr(0, dot);
+
+    return name;
+}
@@ -0,0 +1,162 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Microbenchmark of GroupedHistory alone. Every access of the workloads is
+ * treated as a miss, and does what the grouped history stages do with it:
+ * an update with the delta from the previous miss, a lookup of the block
+ * and a range query over its page.
+ */
+
+#include "bench_common.hh"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#define LOGD(...)
+#define LOGE(...)
+#define LOG(...)
+
+#include "grouped_history.hh"
+
+#define PAGE_SIZE 4096
+
+/* The merge rule of the grouped history stages */
+class Callbacks : public GroupedHistoryCallbacks<int64_t>
+{
+public:
+    virtual bool CanMerge(const GroupedHistoryEntry<int64_t>& a,
+                          const GroupedHistoryEntry<int64_t>& b)
+    {
+        if (a.Data != b.Data) return false;
+        if (a.LastAddr + BLOCK_SIZE < b.FirstAddr) return false;
+        return true;
+    }
+};
+
+class Counter
+{
+public:
+    int Count;
+
+    Counter() : Count(0) { }
+
+    bool operator()(const GroupedHistoryEntry<int64_t>& entry)
+    {
+        ++Count;
+        return true;
+    }
+};
+
+static int capacity = 2048;
+
+struct BenchResult
+{
+    uint64_t Accesses;
+    double NsPerAccess;
+    double AllocsPerAccess;
+    long RssKb;     /* Growth of the resident set during the replay */
+    long PeakRssKb; /* Peak of that growth */
+    double Occupancy;
+    double Hits;
+};
+
+static void measure(const Workload& work, BenchResult& result)
+{
+    long rss = rss_kb();
+    reset_peak_rss();
+
+    Callbacks callbacks;
+    GroupedHistory<int64_t> history(callbacks, BLOCK_SIZE, capacity);
+    Counter counter;
+    int found = 0;
+
+    uint64_t before = allocations;
+    double start = now_ns();
+    Addr prev = 0;
+
+    for (size_t i = 0; i < work.size(); ++i)
+    {
+        Addr block = work[i].Addr & ~(Addr)(BLOCK_SIZE - 1);
+        Addr page = block & ~(Addr)(PAGE_SIZE - 1);
+
+        if (prev != 0)
+            history.Update(work[i].Time, prev, (int64_t)block - (int64_t)prev);
+
+        found += (history.Get(block) != NULL);
+        history.GetRange(page, page + PAGE_SIZE - 1, counter);
+
+        prev = block;
+    }
+
+    double time = now_ns() - start;
+    double n = (work.size() > 0) ? (double)work.size() : 1.0;
+
+    result.Accesses = work.size();
+    result.NsPerAccess = time / n;
+    result.AllocsPerAccess = (allocations - before) / n;
+    result.RssKb = rss_kb() - rss;
+    result.PeakRssKb = peak_rss_kb() - rss;
+    result.Occupancy = (double)history.Size() / history.Capacity();
+    result.Hits = found / n;
+}
+
+int main(int argc, char** argv)
+{
+    int accesses = 1000000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:c:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': accesses = atoi(optarg); break;
+        case 'c': capacity = atoi(optarg); break;
+        default:
+            fprintf(stderr,
+                    "Usage: %s [-n accesses] [-c capacity] [trace...]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    printf("                           BENCHMARK: GroupedHistory (capacity %d)\n",
+           capacity);
+    printf("--------------------------------------------------------------------------\n");
+    printf("       TEST      ACCESSES  NS/ACC ALLOC/ACC  RSS KiB PEAK KiB  OCC  HIT\n");
+    printf("--------------------------------------------------------------------------\n");
+
+    int failed = 0;
+    int count = NUM_SYNTHETIC_WORKLOADS + argc - optind;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const char* name = (i < NUM_SYNTHETIC_WORKLOADS)
+            ? synthetic_workloads[i]
+            : argv[optind + i - NUM_SYNTHETIC_WORKLOADS];
+
+        BenchResult r;
+
+        if (run_isolated(name, accesses, measure, r) != 0)
+        {
+            fprintf(stderr, "Failed to benchmark %s\n", name);
+            failed = 1;
+            continue;
+        }
+
+        printf(" %-13s %10llu %7.1f %9.4f %8ld %8ld %4.2f %4.2f\n",
+               test_name(name).c_str(), (unsigned long long)r.Accesses,
+               r.NsPerAccess, r.AllocsPerAccess, r.RssKb, r.PeakRssKb,
+               r.Occupancy, r.Hits);
+    }
+
+    printf("--------------------------------------------------------------------------\n");
+
+    return failed;
+}
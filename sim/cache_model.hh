@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Set-associative cache with true LRU replacement.
+ *
+ * Besides the tag, every line keeps the prefetch bit visible to the
+ * prefetcher and a private "unused prefetch" flag that the simulator uses
+ * to count useful and polluting prefetches independently of what the
+ * prefetcher does with its own bit.
+ */
+class CacheModel
+{
+public:
+    struct Line
+    {
+        uint64_t Tag;
+        uint64_t LastUse;
+        bool Valid;
+        bool PrefetchBit;
+        bool Prefetched;
+    };
+
+private:
+    int mBlockSize;
+    int mNumSets;
+    int mAssoc;
+    uint64_t mUseCounter;
+
+    std::vector<Line> mLines;
+
+public:
+    CacheModel(int size, int assoc, int blockSize)
+        : mBlockSize(blockSize), mNumSets(size / (assoc * blockSize)),
+          mAssoc(assoc), mUseCounter(0)
+    {
+        if (mNumSets < 1) mNumSets = 1;
+        mLines.resize(mNumSets * mAssoc);
+
+        for (size_t i = 0; i < mLines.size(); ++i)
+        {
+            mLines[i].Valid = false;
+            mLines[i].PrefetchBit = false;
+            mLines[i].Prefetched = false;
+        }
+    }
+
+    /* Returns the line holding the address, or NULL. Does not touch LRU. */
+    Line* Find(uint64_t addr)
+    {
+        uint64_t block = addr / mBlockSize;
+        Line* set = &mLines[(block % mNumSets) * mAssoc];
+
+        for (int i = 0; i < mAssoc; ++i)
+            if (set[i].Valid && set[i].Tag == block) return &set[i];
+
+        return NULL;
+    }
+
+    /* Marks the line as most recently used */
+    void Touch(Line* line)
+    {
+        line->LastUse = ++mUseCounter;
+    }
+
+    /**
+     * Inserts the block containing the address, evicting the least recently
+     * used line of the set if needed. The evicted line is copied into
+     * `victim` (Valid is false if nothing was evicted).
+     */
+    Line* Insert(uint64_t addr, Line& victim)
+    {
+        uint64_t block = addr / mBlockSize;
+        Line* set = &mLines[(block % mNumSets) * mAssoc];
+        Line* line = &set[0];
+
+        for (int i = 0; i < mAssoc; ++i)
+        {
+            if (!set[i].Valid) { line = &set[i]; break; }
+            if (set[i].LastUse < line->LastUse) line = &set[i];
+        }
+
+        victim = *line;
+
+        line->Tag = block;
+        line->Valid = true;
+        line->PrefetchBit = false;
+        line->Prefetched = false;
+        Touch(line);
+
+        return line;
+    }
+};
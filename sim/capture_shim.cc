@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Trace capture shim for M5. It wraps an unmodified prefetcher.cc, records
+ * the AccessStat stream seen by prefetch_access() into a binary trace (see
+ * trace_format.hh) and forwards every call to the wrapped prefetcher.
+ *
+ * Usage: copy this file as prefetcher.cc into the M5 prefetcher directory,
+ * together with trace_reader.hh, trace_format.hh and the real prefetcher
+ * renamed to user_prefetcher.cc (or set CAPTURE_PREFETCHER to its name).
+ * The trace is written to $PREFETCH_TRACE, "prefetch.trace" by default.
+ */
+
+#ifndef CAPTURE_PREFETCHER
+#  define CAPTURE_PREFETCHER "user_prefetcher.cc"
+#endif /* CAPTURE_PREFETCHER */
+
+/* -------------------------------------------------- Wrapped prefetcher */
+#define prefetch_init     captured_prefetch_init
+#define prefetch_access   captured_prefetch_access
+#define prefetch_complete captured_prefetch_complete
+
+#include CAPTURE_PREFETCHER
+
+#undef prefetch_init
+#undef prefetch_access
+#undef prefetch_complete
+
+/* --------------------------------------------------------------- Capture */
+#include "trace_format.hh"
+
+#include <cstdlib>
+
+static TraceWriter capture_writer; /* Closed by its destructor at exit */
+
+void prefetch_init(void)
+{
+    const char* path = getenv("PREFETCH_TRACE");
+    if (path == NULL) path = "prefetch.trace";
+
+    if (!capture_writer.Open(path))
+        fprintf(stderr, "Cannot open trace %s for writing\n", path);
+
+    captured_prefetch_init();
+}
+
+void prefetch_access(AccessStat stat)
+{
+    TraceRecord rec;
+    rec.Pc = stat.pc;
+    rec.Addr = stat.mem_addr;
+    rec.Time = stat.time;
+    rec.Miss = stat.miss;
+
+    capture_writer.Append(rec);
+
+    captured_prefetch_access(stat);
+}
+
+void prefetch_complete(Addr addr)
+{
+    captured_prefetch_complete(addr);
+}
@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Prefetcher interface of the standalone replay simulator. It mirrors the
+ * interface.hh of the M5 framework so that every prefetcher.cc can be built
+ * against it without any modification.
+ */
+
+#ifndef __INTERFACE_HH__
+#define __INTERFACE_HH__
+
+#include <stdint.h>
+
+/* ------------------------------------------------------ System parameters */
+#define BLOCK_SIZE        64
+#define MAX_QUEUE_SIZE    100
+#define MAX_PHYS_MEM_ADDR ((uint64_t)(256 * 1024 * 1024) - 1)
+
+typedef uint64_t Addr;
+typedef int64_t Tick;
+
+struct AccessStat
+{
+    Addr pc;       /* The address of the instruction that caused the access */
+    Addr mem_addr; /* The memory address that was requested */
+    Tick time;     /* The simulator time cycle when the request was sent */
+    int miss;      /* Whether this demand access was a cache hit or miss */
+};
+
+/* ------------------------------------- Functions provided by the prefetcher */
+void prefetch_init(void);
+void prefetch_access(AccessStat stat);
+void prefetch_complete(Addr addr);
+
+/* Optional, only called by the simulator at the end of a trace. Prefetchers
+   may define it to dump their own statistics. */
+void prefetch_final(void) __attribute__((weak));
+
+/* Optional, only called by the benchmarks. Returns the fraction of the
+   prefetcher tables in use, negative if unknown. */
+double prefetch_occupancy(void) __attribute__((weak));
+
+/* Optional, only called by the simulator. Creates and destroys independent
+   prefetcher instances, and selects the one which the prefetch_* calls of
+   the calling thread go to, NULL for the default one. */
+void* prefetch_create(void) __attribute__((weak));
+void prefetch_destroy(void* instance) __attribute__((weak));
+void prefetch_select(void* instance) __attribute__((weak));
+
+/* ----------------------------------------- Functions provided by the cache */
+void issue_prefetch(Addr addr);
+
+int get_prefetch_bit(Addr addr);
+void set_prefetch_bit(Addr addr);
+void clear_prefetch_bit(Addr addr);
+
+int in_mshr_queue(Addr addr);
+int in_cache(Addr addr);
+int current_queue_size(void);
+
+/* ---------------------------------------------------------- Debug output */
+extern int sim_debug;
+void sim_dprintf(const char* flag, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+#define DPRINTF(flag, ...) \
+    do { if (sim_debug) sim_dprintf(#flag, __VA_ARGS__); } while (0)
+
+#endif /* __INTERFACE_HH__ */
@@ -0,0 +1,232 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Standalone trace-driven simulator. It replays L2 access traces through a
+ * set-associative L2 model and an in-flight prefetch queue, and drives the
+ * prefetcher linked with it through the standard interface.
+ *
+ * Every trace is replayed in a forked child process, so that the global
+ * state of the prefetcher starts from scratch for every test.
+ */
+
+#include "simulator.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* ------------------------------------------------------------- Simulation */
+static int run_trace(const char* path, SimStats& result)
+{
+    TraceReader reader;
+    if (!reader.Open(path))
+    {
+        fprintf(stderr, "Cannot open trace %s\n", path);
+        return 1;
+    }
+
+    sim_start();
+
+    TraceRecord recs[SIM_BATCH_SIZE];
+    int count = 0;
+
+    while (true)
+    {
+        bool more = reader.Next(recs[count]);
+        if (more) ++count;
+
+        if (count == SIM_BATCH_SIZE || (!more && count > 0))
+        {
+            sim_access_batch(recs, count);
+            count = 0;
+        }
+
+        if (!more) break;
+    }
+
+    sim_finish(result);
+    if (prefetch_final && !config.Baseline) prefetch_final();
+
+    sim_stop();
+    return 0;
+}
+
+/* Replays the trace in a child process and collects its statistics */
+static int run_trace_isolated(const char* path, SimStats& result)
+{
+    int fds[2];
+    if (pipe(fds) != 0) return 1;
+
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid < 0) return 1;
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+
+        int ret = run_trace(path, result);
+        if (ret == 0 && write(fds[1], &result, sizeof(result)) != sizeof(result))
+            ret = 1;
+
+        close(fds[1]);
+        fflush(stdout);
+        fflush(stderr);
+        _exit(ret);
+    }
+
+    close(fds[1]);
+    ssize_t len = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    if (len != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return 1;
+
+    return 0;
+}
+
+/* ----------------------------------------------------------------- Report */
+/* One tab-separated line of raw statistics per trace, for the sweeps */
+static int raw_output = 0;
+
+static std::string test_name(const char* path)
+{
+    std::string name(path);
+
+    size_t slash = name.find_last_of('/');
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+
+    size_t dot = name.find('.');
+    if (dot != std::string::npos && dot > 0) name = name.substr(0, dot);
+
+    return name;
+}
+
+/* The prefetcher name is taken from the binary name (sim-<name>) */
+static std::string prefetcher_name(const char* prog)
+{
+    std::string name = test_name(prog);
+    if (name.compare(0, 4, "sim-") == 0) name = name.substr(4);
+    return name;
+}
+
+static void print_header(const std::string& prefetcher)
+{
+    if (raw_output) return;
+
+    printf("                           PREFETCHER: %s\n", prefetcher.c_str());
+    printf("----------------------------------------------------------------------\n");
+    printf("       TEST      ACC  COV    IDENT     ISSUED    MISSES      LATE\n");
+    printf("----------------------------------------------------------------------\n");
+}
+
+static void print_row(const std::string& name, const SimStats& s)
+{
+    if (raw_output)
+    {
+        printf("%s\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\n",
+               name.c_str(), (unsigned long long)s.Accesses,
+               (unsigned long long)s.Misses, (unsigned long long)s.Identified,
+               (unsigned long long)s.Issued, (unsigned long long)s.Useful,
+               (unsigned long long)s.Late, (unsigned long long)s.Dropped,
+               (unsigned long long)s.Polluted);
+        return;
+    }
+
+    double acc = (s.Issued > 0) ? (double)s.Useful / s.Issued : 0.0;
+    double cov = (s.Useful + s.Misses > 0)
+        ? (double)s.Useful / (s.Useful + s.Misses) : 0.0;
+
+    printf(" %-15s %4.2f %4.2f %9llu %10llu %9llu %9llu\n",
+           name.c_str(), acc, cov,
+           (unsigned long long)s.Identified, (unsigned long long)s.Issued,
+           (unsigned long long)s.Misses, (unsigned long long)s.Late);
+}
+
+static void print_footer()
+{
+    if (raw_output) return;
+
+    printf("----------------------------------------------------------------------\n");
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] trace...\n"
+            "  -s <KiB>    L2 size (default %d)\n"
+            "  -a <ways>   L2 associativity (default %d)\n"
+            "  -l <ticks>  prefetch latency (default %lld)\n"
+            "  -i <ticks>  minimum interval between two completions (default %lld)\n"
+            "  -m          passes the miss flag recorded in the trace to the\n"
+            "              prefetcher instead of the one of the L2 model\n"
+            "  -b          replays without the prefetcher, as a baseline\n"
+            "  -t          prints one tab-separated line of raw statistics per\n"
+            "              trace: name, accesses, misses, identified, issued,\n"
+            "              useful, late, dropped, polluted\n"
+            "  -d          enables DPRINTF output on stderr\n",
+            prog, config.CacheSize / 1024, config.Assoc,
+            (long long)config.Latency, (long long)config.Interval);
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:a:l:i:mbtdh")) != -1)
+    {
+        switch (opt)
+        {
+        case 's': config.CacheSize = atoi(optarg) * 1024; break;
+        case 'a': config.Assoc = atoi(optarg); break;
+        case 'l': config.Latency = atoll(optarg); break;
+        case 'i': config.Interval = atoll(optarg); break;
+        case 'm': config.UseTraceMiss = 1; break;
+        case 'b': config.Baseline = 1; break;
+        case 't': raw_output = 1; break;
+        case 'd': sim_debug = 1; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (optind >= argc || config.CacheSize <= 0 || config.Assoc <= 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int failed = 0;
+
+    print_header(prefetcher_name(argv[0]));
+
+    for (int i = optind; i < argc; ++i)
+    {
+        SimStats result;
+
+        if (run_trace_isolated(argv[i], result) != 0)
+        {
+            fprintf(stderr, "Failed to replay %s\n", argv[i]);
+            failed = 1;
+            continue;
+        }
+
+        print_row(test_name(argv[i]), result);
+    }
+
+    print_footer();
+
+    return failed;
+}
@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+/**
+ * In-flight prefetch queue (MSHR queue) with a fixed memory latency and a
+ * minimum interval between two completions, which models the limited
+ * memory bandwidth. Requests complete in FIFO order.
+ *
+ * The requests live in a ring buffer allocated by the constructor, so the
+ * replay itself never allocates and the benchmarks only count the
+ * allocations of the prefetcher.
+ */
+class PrefetchQueue
+{
+public:
+    struct Request
+    {
+        uint64_t Addr;
+        int64_t Issued;
+        int64_t Done;
+        bool Demanded; /* A demand miss hit this request while in flight */
+    };
+
+private:
+    int mCapacity;
+    int64_t mLatency;
+    int64_t mInterval;
+    int64_t mLastDone;
+
+    std::vector<Request> mRequests;
+    int mHead;
+    int mCount;
+
+public:
+    PrefetchQueue(int capacity, int64_t latency, int64_t interval)
+        : mCapacity(capacity), mLatency(latency), mInterval(interval),
+          mLastDone(0), mRequests(capacity), mHead(0), mCount(0)
+    { }
+
+    int Size() const { return mCount; }
+    bool Full() const { return mCount >= mCapacity; }
+    bool Empty() const { return mCount == 0; }
+
+    Request* Find(uint64_t addr)
+    {
+        for (int i = 0; i < mCount; ++i)
+        {
+            Request& req = mRequests[(mHead + i) % mCapacity];
+            if (req.Addr == addr) return &req;
+        }
+
+        return NULL;
+    }
+
+    /* The queue must not be full */
+    void Push(uint64_t addr, int64_t now)
+    {
+        Request& req = mRequests[(mHead + mCount) % mCapacity];
+        req.Addr = addr;
+        req.Issued = now;
+        req.Done = now + mLatency;
+        if (req.Done < mLastDone + mInterval) req.Done = mLastDone + mInterval;
+        req.Demanded = false;
+
+        mLastDone = req.Done;
+        ++mCount;
+    }
+
+    /* Returns true and pops the oldest request if it has completed by `now` */
+    bool PopCompleted(int64_t now, Request& req)
+    {
+        if (mCount == 0 || mRequests[mHead].Done > now) return false;
+
+        req = mRequests[mHead];
+        mHead = (mHead + 1) % mCapacity;
+        --mCount;
+        return true;
+    }
+};
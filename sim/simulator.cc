@@ -0,0 +1,329 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#include "simulator.hh"
+#include "cache_model.hh"
+#include "prefetch_queue.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdarg>
+
+/* ---------------------------------------------------------- Configuration */
+SimConfig config = { 512 * 1024, 8, 600, 40, 0, 0 };
+
+int sim_debug = 0;
+
+/* Simulator which the interface calls of this thread go to */
+static __thread Simulator* current = NULL;
+
+/* -------------------------------------------------------------- Simulator */
+Simulator::Simulator(const SimConfig& config, bool isolated)
+    : mConfig(config), mNow(0), mPrefetcher(NULL), mBatch(NULL)
+{
+    mCache = new CacheModel(mConfig.CacheSize, mConfig.Assoc, BLOCK_SIZE);
+    mQueue = new PrefetchQueue(MAX_QUEUE_SIZE, mConfig.Latency,
+                               mConfig.Interval);
+    memset(&mStats, 0, sizeof(mStats));
+
+    if (mConfig.Baseline) return;
+
+    if (isolated && prefetch_create) mPrefetcher = prefetch_create();
+
+    Enter();
+    prefetch_init();
+}
+
+Simulator::~Simulator()
+{
+    if (current == this)
+    {
+        current = NULL;
+        if (prefetch_select) prefetch_select(NULL);
+    }
+
+    if (mPrefetcher != NULL) prefetch_destroy(mPrefetcher);
+
+    delete mQueue;
+    delete mCache;
+}
+
+void Simulator::Enter()
+{
+    if (current == this) return;
+
+    current = this;
+    if (prefetch_select) prefetch_select(mPrefetcher);
+}
+
+void Simulator::Fill(Addr addr, bool prefetched)
+{
+    CacheModel::Line victim;
+    CacheModel::Line* line = mCache->Insert(addr, victim);
+
+    line->Prefetched = prefetched;
+    if (victim.Valid && victim.Prefetched) ++mStats.Polluted;
+}
+
+void Simulator::CompletePrefetches(Tick time)
+{
+    PrefetchQueue::Request req;
+
+    while (mQueue->PopCompleted(time, req))
+    {
+        mNow = req.Done;
+
+        /* A demanded request has already been filled by the demand miss */
+        if (!req.Demanded && mCache->Find(req.Addr) == NULL)
+            Fill(req.Addr, true);
+
+        if (!mConfig.Baseline) prefetch_complete(req.Addr);
+    }
+}
+
+void Simulator::Access(const TraceRecord& rec)
+{
+    Enter();
+
+    int miss = Demand(rec);
+
+    AccessStat stat;
+    stat.pc = rec.Pc;
+    stat.mem_addr = rec.Addr;
+    stat.time = rec.Time;
+    stat.miss = miss;
+
+    if (!mConfig.Baseline) prefetch_access(stat);
+}
+
+void Simulator::Access(const TraceRecord* recs, int count)
+{
+    if (mConfig.Baseline || !prefetch_access_batch)
+    {
+        for (int i = 0; i < count; ++i) Access(recs[i]);
+        return;
+    }
+
+    Enter();
+
+    for (int first = 0; first < count; first += SIM_BATCH_SIZE)
+    {
+        int n = count - first;
+        if (n > SIM_BATCH_SIZE) n = SIM_BATCH_SIZE;
+
+        mBatch = recs + first;
+        for (int i = 0; i < n; ++i)
+        {
+            mPcs[i] = mBatch[i].Pc;
+            mAddrs[i] = mBatch[i].Addr;
+            mTimes[i] = mBatch[i].Time;
+        }
+
+        AccessBatch batch = { n, mPcs, mAddrs, mTimes, mMisses };
+        prefetch_access_batch(batch, DemandAt, this);
+    }
+
+    mBatch = NULL;
+}
+
+void Simulator::DemandAt(void* context, int i)
+{
+    Simulator* sim = static_cast<Simulator*>(context);
+    sim->mMisses[i] = sim->Demand(sim->mBatch[i]);
+}
+
+int Simulator::Demand(const TraceRecord& rec)
+{
+    CompletePrefetches(rec.Time);
+    mNow = rec.Time;
+
+    ++mStats.Accesses;
+
+    int miss = 0;
+    CacheModel::Line* line = mCache->Find(rec.Addr);
+
+    if (line != NULL)
+    {
+        mCache->Touch(line);
+        if (line->Prefetched)
+        {
+            ++mStats.Useful;
+            line->Prefetched = false;
+        }
+    }
+    else
+    {
+        miss = 1;
+
+        PrefetchQueue::Request* req =
+            mQueue->Find(rec.Addr & ~(Addr)(BLOCK_SIZE - 1));
+        if (req != NULL && !req->Demanded)
+        {
+            /* The prefetch was right but arrives too late */
+            req->Demanded = true;
+            ++mStats.Useful;
+            ++mStats.Late;
+        }
+        else ++mStats.Misses;
+
+        Fill(rec.Addr, false);
+    }
+
+    return mConfig.UseTraceMiss ? rec.Miss : miss;
+}
+
+void Simulator::Finish(SimStats& result)
+{
+    Enter();
+
+    /* Lets the remaining prefetches land, they still count as issued */
+    CompletePrefetches(INT64_MAX);
+
+    result = mStats;
+}
+
+void Simulator::Final()
+{
+    Enter();
+    if (prefetch_final && !mConfig.Baseline) prefetch_final();
+}
+
+double Simulator::Occupancy()
+{
+    Enter();
+    return prefetch_occupancy ? prefetch_occupancy() : -1;
+}
+
+/* -------------------------------------------------------- Cache interface */
+void Simulator::IssuePrefetch(Addr addr)
+{
+    ++mStats.Identified;
+
+    addr &= ~(Addr)(BLOCK_SIZE - 1);
+    if (addr > MAX_PHYS_MEM_ADDR) return;
+    if (mCache->Find(addr) != NULL || mQueue->Find(addr) != NULL) return;
+
+    if (mQueue->Full())
+    {
+        ++mStats.Dropped;
+        return;
+    }
+
+    mQueue->Push(addr, mNow);
+    ++mStats.Issued;
+}
+
+int Simulator::GetPrefetchBit(Addr addr)
+{
+    CacheModel::Line* line = mCache->Find(addr);
+    return (line != NULL) ? line->PrefetchBit : 0;
+}
+
+void Simulator::SetPrefetchBit(Addr addr)
+{
+    CacheModel::Line* line = mCache->Find(addr);
+    if (line != NULL) line->PrefetchBit = true;
+}
+
+void Simulator::ClearPrefetchBit(Addr addr)
+{
+    CacheModel::Line* line = mCache->Find(addr);
+    if (line != NULL) line->PrefetchBit = false;
+}
+
+int Simulator::InMshrQueue(Addr addr)
+{
+    return mQueue->Find(addr & ~(Addr)(BLOCK_SIZE - 1)) != NULL;
+}
+
+int Simulator::InCache(Addr addr)
+{
+    return mCache->Find(addr) != NULL;
+}
+
+int Simulator::CurrentQueueSize()
+{
+    return mQueue->Size();
+}
+
+void issue_prefetch(Addr addr)
+{
+    current->IssuePrefetch(addr);
+}
+
+int get_prefetch_bit(Addr addr)
+{
+    return current->GetPrefetchBit(addr);
+}
+
+void set_prefetch_bit(Addr addr)
+{
+    current->SetPrefetchBit(addr);
+}
+
+void clear_prefetch_bit(Addr addr)
+{
+    current->ClearPrefetchBit(addr);
+}
+
+int in_mshr_queue(Addr addr)
+{
+    return current->InMshrQueue(addr);
+}
+
+int in_cache(Addr addr)
+{
+    return current->InCache(addr);
+}
+
+int current_queue_size(void)
+{
+    return current->CurrentQueueSize();
+}
+
+void sim_dprintf(const char* flag, const char* format, ...)
+{
+    va_list args;
+
+    fprintf(stderr, "%lld: %s: ",
+            (long long)(current != NULL ? current->Now() : 0), flag);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+/* ------------------------------------------------------------- Simulation */
+static Simulator* simulator = NULL;
+
+void sim_start(void)
+{
+    sim_stop();
+    simulator = new Simulator(config, false);
+}
+
+void sim_access(const TraceRecord& rec)
+{
+    simulator->Access(rec);
+}
+
+void sim_access_batch(const TraceRecord* recs, int count)
+{
+    simulator->Access(recs, count);
+}
+
+void sim_finish(SimStats& result)
+{
+    simulator->Finish(result);
+}
+
+void sim_stop(void)
+{
+    delete simulator;
+    simulator = NULL;
+}
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Core of the replay simulator, shared by the simulator and the
+ * benchmarks: the L2 model, the in-flight prefetch queue and the cache side
+ * of the prefetcher interface.
+ *
+ * A Simulator models one L2 and drives one prefetcher instance. The cache
+ * functions of the interface go to the simulator which the calling thread
+ * last entered, so several simulators can run in one thread, interleaved,
+ * or each in a thread of its own.
+ */
+
+#pragma once
+
+#include "interface.hh"
+#include "trace_format.hh"
+#include "access_batch.hh"
+
+/* Accesses handed to the prefetcher at once by the batched replay */
+#define SIM_BATCH_SIZE 256
+
+class CacheModel;
+class PrefetchQueue;
+
+/* ---------------------------------------------------------- Configuration */
+struct SimConfig
+{
+    int CacheSize;
+    int Assoc;
+    Tick Latency;
+    Tick Interval;
+    int UseTraceMiss;
+    int Baseline; /* Runs the cache model alone, the prefetcher is not called */
+};
+
+struct SimStats
+{
+    uint64_t Accesses;
+    uint64_t Misses;     /* Demand misses not covered by any prefetch */
+    uint64_t Identified; /* Calls to issue_prefetch */
+    uint64_t Issued;     /* Prefetches actually sent to memory */
+    uint64_t Useful;     /* Prefetched blocks referenced by a demand access */
+    uint64_t Late;       /* Useful prefetches still in flight when demanded */
+    uint64_t Dropped;    /* Prefetches dropped because the queue was full */
+    uint64_t Polluted;   /* Prefetched blocks evicted before any use */
+};
+
+extern SimConfig config;
+
+/* -------------------------------------------------------------- Simulator */
+class Simulator
+{
+private:
+    SimConfig mConfig;
+    CacheModel* mCache;
+    PrefetchQueue* mQueue;
+    SimStats mStats;
+    Tick mNow;
+    void* mPrefetcher; /* NULL for the default instance */
+
+    /* Batch being replayed, as a structure of arrays */
+    const TraceRecord* mBatch;
+    Addr mPcs[SIM_BATCH_SIZE];
+    Addr mAddrs[SIM_BATCH_SIZE];
+    Tick mTimes[SIM_BATCH_SIZE];
+    int mMisses[SIM_BATCH_SIZE];
+
+    Simulator(const Simulator&);
+    Simulator& operator=(const Simulator&);
+
+public:
+    /* Creates an empty cache and prefetch queue and initializes the
+       prefetcher: an instance of its own if isolated and the variant
+       provides prefetch_create, the default one otherwise */
+    Simulator(const SimConfig& config, bool isolated);
+    ~Simulator();
+
+    bool Isolated() const { return mPrefetcher != NULL; }
+    Tick Now() const { return mNow; }
+
+    /* Replays one access */
+    void Access(const TraceRecord& rec);
+
+    /* Replays the accesses in order, through prefetch_access_batch if the
+       prefetcher provides it. The results are the same. */
+    void Access(const TraceRecord* recs, int count);
+
+    /* Lets the remaining prefetches land and returns the statistics */
+    void Finish(SimStats& result);
+
+    /* Calls prefetch_final and prefetch_occupancy on its instance */
+    void Final();
+    double Occupancy();
+
+    /* Cache side of the interface */
+    void IssuePrefetch(Addr addr);
+    int GetPrefetchBit(Addr addr);
+    void SetPrefetchBit(Addr addr);
+    void ClearPrefetchBit(Addr addr);
+    int InMshrQueue(Addr addr);
+    int InCache(Addr addr);
+    int CurrentQueueSize();
+
+private:
+    /* Routes the interface calls of this thread to this simulator */
+    void Enter();
+
+    /* Serves a demand access and returns the miss flag for the prefetcher */
+    int Demand(const TraceRecord& rec);
+    static void DemandAt(void* context, int i);
+
+    void Fill(Addr addr, bool prefetched);
+    void CompletePrefetches(Tick time);
+};
+
+/* ------------------------------------------------------------- Simulation */
+
+/* A single simulator, with the default instance of the prefetcher */
+
+/* Creates an empty cache and prefetch queue and initializes the prefetcher */
+void sim_start(void);
+
+/* Replays one access */
+void sim_access(const TraceRecord& rec);
+
+/* Replays the accesses in order, in batches */
+void sim_access_batch(const TraceRecord* recs, int count);
+
+/* Lets the remaining prefetches land and returns the statistics. The
+   models stay alive for prefetch_final until sim_stop. */
+void sim_finish(SimStats& result);
+
+void sim_stop(void);
@@ -0,0 +1,689 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Parameter sweep. Every line of the grid file names a configuration, the
+ * variant it builds and the flags it is compiled with:
+ *
+ *   # name        variant    flags
+ *   baer91        baer91
+ *   baer91-la     baer91     -DLOOKAHEAD_DISTANCE={2,4,8}
+ *
+ * A {a,b,...} group expands into one configuration per alternative, and the
+ * chosen alternatives are appended to the name (baer91-la-2, ...). Every
+ * configuration is compiled to its own simulator, then every (config, trace)
+ * pair is replayed by a simulator process of its own, so no prefetcher
+ * state is ever shared. The compilations and the replays are spread over
+ * all the cores by a work-stealing pool of threads.
+ *
+ * The simulator has no timing model, so the speedup is approximated by the
+ * misses left relative to a replay of the same trace without prefetcher.
+ *
+ * Runs from any directory, after make has built main.o and simulator.o.
+ * They and the sources are found from the location of the sweep binary,
+ * which make builds in sim/build next to them.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/* ---------------------------------------------------------- Configuration */
+struct SweepOptions
+{
+    int Jobs;
+    const char* Build;  /* Directory of main.o and simulator.o, NULL for
+                           the one of the sweep binary */
+    const char* Source; /* sim/ directory, NULL for the parent of the one
+                           of the sweep binary */
+    const char* Output; /* Table file, NULL for stdout */
+};
+
+static SweepOptions options = { 0, NULL, NULL, NULL };
+
+/* Directory of main.o and simulator.o, the simulators are built in its
+   configs/ subdirectory */
+static std::string build_dir;
+
+/* sim/ directory, the prefetchers and common/ are next to it */
+static std::string source;
+
+struct SweepConfig
+{
+    std::string Name;
+    std::string Variant;
+    std::string Flags;
+    std::string Binary;
+    int Built;
+};
+
+struct SweepResult
+{
+    int Valid;
+    unsigned long long Accesses;
+    unsigned long long Misses;
+    unsigned long long Identified;
+    unsigned long long Issued;
+    unsigned long long Useful;
+    unsigned long long Late;
+    unsigned long long Dropped;
+    unsigned long long Polluted;
+};
+
+static std::vector<SweepConfig> configs;
+static std::vector<std::string> traces;
+
+/* results[config * traces + trace], the baselines come after them */
+static std::vector<SweepResult> results;
+
+/* ------------------------------------------------------------------- Grid */
+
+/* Expands the first {a,b,...} group of the line, then the rest recursively */
+static void expand(const std::string& line, const std::string& suffix,
+                   std::vector<std::string>& lines,
+                   std::vector<std::string>& suffixes)
+{
+    size_t open = line.find('{');
+    size_t close = (open != std::string::npos) ? line.find('}', open) : open;
+
+    if (close == std::string::npos)
+    {
+        lines.push_back(line);
+        suffixes.push_back(suffix);
+        return;
+    }
+
+    std::string head = line.substr(0, open);
+    std::string tail = line.substr(close + 1);
+    std::string group = line.substr(open + 1, close - open - 1);
+
+    size_t start = 0;
+    while (true)
+    {
+        size_t comma = group.find(',', start);
+        std::string value = group.substr(start, comma - start);
+
+        expand(head + value + tail, suffix + "-" + value, lines, suffixes);
+
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+}
+
+static int read_grid(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Cannot open grid %s\n", path);
+        return 1;
+    }
+
+    char buf[1024];
+    int lineno = 0;
+
+    while (fgets(buf, sizeof(buf), file) != NULL)
+    {
+        ++lineno;
+
+        std::string line(buf);
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+
+        char name[256], variant[256];
+        int len = 0;
+        if (sscanf(line.c_str(), "%255s %255s %n", name, variant, &len) < 2)
+        {
+            if (line.find_first_not_of(" \t\r\n") == std::string::npos)
+                continue;
+
+            fprintf(stderr, "%s:%d: expected a name and a variant\n",
+                    path, lineno);
+            fclose(file);
+            return 1;
+        }
+
+        std::vector<std::string> flags, suffixes;
+        expand(line.substr(len), "", flags, suffixes);
+
+        for (size_t i = 0; i < flags.size(); ++i)
+        {
+            SweepConfig config;
+            config.Name = std::string(name) + suffixes[i];
+            config.Variant = variant;
+            config.Flags = flags[i].substr(
+                0, flags[i].find_last_not_of(" \t\r\n") + 1);
+            config.Binary = build_dir + "/configs/sim-"
+                + config.Name;
+            config.Built = 0;
+            configs.push_back(config);
+        }
+    }
+
+    fclose(file);
+
+    if (configs.empty())
+    {
+        fprintf(stderr, "%s: no configuration\n", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------- Processes */
+
+/* Runs the command, with its stdout in output if not NULL and its stderr
+   discarded if quiet. Returns its exit status. */
+static int run(const std::vector<std::string>& args, std::string* output,
+               int quiet)
+{
+    std::vector<char*> argv;
+    for (size_t i = 0; i < args.size(); ++i)
+        argv.push_back(const_cast<char*>(args[i].c_str()));
+    argv.push_back(NULL);
+
+    /* Close-on-exec, so that no other child keeps the pipe open */
+    int fds[2] = { -1, -1 };
+    if (output != NULL && pipe2(fds, O_CLOEXEC) != 0) return -1;
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        if (output != NULL)
+        {
+            close(fds[0]);
+            close(fds[1]);
+        }
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        if (output != NULL) dup2(fds[1], STDOUT_FILENO);
+
+        if (quiet)
+        {
+            int null = open("/dev/null", O_WRONLY);
+            if (null >= 0) dup2(null, STDERR_FILENO);
+        }
+
+        execvp(argv[0], &argv[0]);
+        _exit(127);
+    }
+
+    if (output != NULL)
+    {
+        close(fds[1]);
+
+        char buf[4096];
+        ssize_t len;
+        while ((len = read(fds[0], buf, sizeof(buf))) > 0)
+            output->append(buf, len);
+
+        close(fds[0]);
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) return -1;
+
+    return WEXITSTATUS(status);
+}
+
+/* ------------------------------------------------------------------ Tasks */
+struct Task
+{
+    enum { BUILD, REPLAY, BASELINE } Kind;
+    int Config;
+    int Trace;
+};
+
+/* Quotes a path for /bin/sh */
+static std::string quote(const std::string& path)
+{
+    std::string quoted = "'";
+
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        if (path[i] == '\'') quoted += "'\\''";
+        else quoted += path[i];
+    }
+
+    return quoted + "'";
+}
+
+static void build(SweepConfig& config)
+{
+    const char* cxx = getenv("CXX");
+    const char* cxxflags = getenv("CXXFLAGS");
+
+    std::string command = std::string(cxx ? cxx : "g++") + " "
+        + (cxxflags ? cxxflags : "-O2") + " -I" + quote(source)
+        + " -I" + quote(source + "/../common") + " " + config.Flags
+        + " -o " + quote(config.Binary) + " "
+        + quote(build_dir + "/main.o") + " "
+        + quote(build_dir + "/simulator.o") + " "
+        + quote(source + "/../" + config.Variant + "/prefetcher.cc");
+
+    std::vector<std::string> args;
+    args.push_back("/bin/sh");
+    args.push_back("-c");
+    args.push_back(command);
+
+    if (run(args, NULL, 0) == 0)
+        config.Built = 1;
+    else
+        fprintf(stderr, "Failed to build %s: %s\n",
+                config.Name.c_str(), command.c_str());
+}
+
+static void replay(const std::string& binary, const std::string& trace,
+                   int baseline, SweepResult& result)
+{
+    std::vector<std::string> args;
+    args.push_back(binary);
+    args.push_back("-t");
+    if (baseline) args.push_back("-b");
+    args.push_back(trace);
+
+    std::string output;
+    result.Valid = 0;
+
+    if (run(args, &output, 1) != 0)
+    {
+        fprintf(stderr, "Failed to replay %s with %s\n",
+                trace.c_str(), binary.c_str());
+        return;
+    }
+
+    /* name, accesses, misses, identified, issued, useful, late, dropped,
+       polluted */
+    size_t tab = output.find('\t');
+    if (tab == std::string::npos) return;
+
+    result.Valid = sscanf(output.c_str() + tab,
+                          "%llu %llu %llu %llu %llu %llu %llu %llu",
+                          &result.Accesses, &result.Misses,
+                          &result.Identified, &result.Issued, &result.Useful,
+                          &result.Late, &result.Dropped,
+                          &result.Polluted) == 8;
+}
+
+static void execute(const Task& task)
+{
+    switch (task.Kind)
+    {
+    case Task::BUILD:
+        build(configs[task.Config]);
+        break;
+
+    case Task::REPLAY:
+        if (!configs[task.Config].Built) break;
+        replay(configs[task.Config].Binary, traces[task.Trace], 0,
+               results[task.Config * traces.size() + task.Trace]);
+        break;
+
+    case Task::BASELINE:
+        /* The cache model does not depend on the configuration */
+        for (size_t i = 0; i < configs.size(); ++i)
+        {
+            if (!configs[i].Built) continue;
+            replay(configs[i].Binary, traces[task.Trace], 1,
+                   results[configs.size() * traces.size() + task.Trace]);
+            break;
+        }
+        break;
+    }
+}
+
+/* -------------------------------------------------------------- Scheduler */
+
+/**
+ * Every worker owns a deque of tasks. It takes the tasks from the front of
+ * its own deque, and when it is empty, steals from the back of the others,
+ * so that a worker stuck with a long replay does not hold back the tasks
+ * dealt to it. No task spawns another one, so a worker stops when every
+ * deque is empty.
+ */
+struct Worker
+{
+    pthread_t Thread;
+    pthread_mutex_t Lock;
+    std::deque<Task> Tasks;
+    int Index;
+};
+
+static std::vector<Worker> workers;
+
+static bool take(Worker& worker, Task& task, bool front)
+{
+    pthread_mutex_lock(&worker.Lock);
+
+    bool found = !worker.Tasks.empty();
+    if (found && front)
+    {
+        task = worker.Tasks.front();
+        worker.Tasks.pop_front();
+    }
+    else if (found)
+    {
+        task = worker.Tasks.back();
+        worker.Tasks.pop_back();
+    }
+
+    pthread_mutex_unlock(&worker.Lock);
+    return found;
+}
+
+static void* work(void* arg)
+{
+    Worker& self = *(Worker*)arg;
+    int count = workers.size();
+    Task task;
+
+    while (true)
+    {
+        bool found = take(self, task, true);
+
+        for (int i = 1; i < count && !found; ++i)
+            found = take(workers[(self.Index + i) % count], task, false);
+
+        if (!found) break;
+
+        execute(task);
+    }
+
+    return NULL;
+}
+
+/* Deals the tasks round-robin and waits for all of them */
+static void run_all(const std::vector<Task>& tasks)
+{
+    for (size_t i = 0; i < tasks.size(); ++i)
+        workers[i % workers.size()].Tasks.push_back(tasks[i]);
+
+    for (size_t i = 0; i < workers.size(); ++i)
+        pthread_create(&workers[i].Thread, NULL, work, &workers[i]);
+
+    for (size_t i = 0; i < workers.size(); ++i)
+        pthread_join(workers[i].Thread, NULL);
+}
+
+/* ----------------------------------------------------------------- Report */
+static std::string test_name(const std::string& path)
+{
+    std::string name(path);
+
+    size_t slash = name.find_last_of('/');
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+
+    size_t dot = name.find('.');
+    if (dot != std::string::npos && dot > 0) name = name.substr(0, dot);
+
+    return name;
+}
+
+static double accuracy(const SweepResult& r)
+{
+    return (r.Issued > 0) ? (double)r.Useful / r.Issued : 0.0;
+}
+
+static double coverage(const SweepResult& r)
+{
+    return (r.Useful + r.Misses > 0)
+        ? (double)r.Useful / (r.Useful + r.Misses) : 0.0;
+}
+
+/* Misses left relative to the baseline, negative if unknown */
+static double miss_ratio(const SweepResult& r, const SweepResult& base)
+{
+    if (!base.Valid || base.Misses == 0) return -1;
+    return (double)r.Misses / base.Misses;
+}
+
+static void print_ratio(FILE* file, double ratio)
+{
+    if (ratio < 0) fprintf(file, "     -");
+    else fprintf(file, " %5.1f", ratio * 100);
+}
+
+static void print_table(FILE* file, const char* grid)
+{
+    size_t ntraces = traces.size();
+    const SweepResult* base = &results[configs.size() * ntraces];
+
+    fprintf(file, "                                SWEEP: %s\n", grid);
+    fprintf(file, "-------------------------------------------------------------------------------\n");
+    fprintf(file, " CONFIG                  TEST            ACC  COV     ISSUED    MISSES  LATE MISS%%\n");
+    fprintf(file, "-------------------------------------------------------------------------------\n");
+
+    for (size_t c = 0; c < configs.size(); ++c)
+    {
+        for (size_t t = 0; t < ntraces; ++t)
+        {
+            const SweepResult& r = results[c * ntraces + t];
+
+            fprintf(file, " %-23s %-15s", configs[c].Name.c_str(),
+                    test_name(traces[t]).c_str());
+
+            if (!r.Valid)
+            {
+                fprintf(file, " failed\n");
+                continue;
+            }
+
+            fprintf(file, " %4.2f %4.2f %10llu %9llu %5.2f",
+                    accuracy(r), coverage(r), r.Issued, r.Misses,
+                    (r.Useful > 0) ? (double)r.Late / r.Useful : 0.0);
+            print_ratio(file, miss_ratio(r, base[t]));
+            fprintf(file, "\n");
+        }
+    }
+
+    /* Averages of every configuration, the geometric mean for the ratios */
+    fprintf(file, "-------------------------------------------------------------------------------\n");
+    fprintf(file, " CONFIG                  MEAN            ACC  COV                        MISS%%\n");
+    fprintf(file, "-------------------------------------------------------------------------------\n");
+
+    for (size_t c = 0; c < configs.size(); ++c)
+    {
+        double acc = 0, cov = 0, logs = 0;
+        int valid = 0, ratios = 0;
+
+        for (size_t t = 0; t < ntraces; ++t)
+        {
+            const SweepResult& r = results[c * ntraces + t];
+            if (!r.Valid) continue;
+
+            acc += accuracy(r);
+            cov += coverage(r);
+            ++valid;
+
+            double ratio = miss_ratio(r, base[t]);
+            if (ratio > 0)
+            {
+                logs += log(ratio);
+                ++ratios;
+            }
+        }
+
+        fprintf(file, " %-23s %-15d", configs[c].Name.c_str(), valid);
+
+        if (valid == 0)
+        {
+            fprintf(file, " failed\n");
+            continue;
+        }
+
+        fprintf(file, " %4.2f %4.2f                       ",
+                acc / valid, cov / valid);
+        print_ratio(file, (ratios > 0) ? exp(logs / ratios) : -1);
+        fprintf(file, "\n");
+    }
+
+    fprintf(file, "-------------------------------------------------------------------------------\n");
+}
+
+/* Removes the last component of the path */
+static int parent(std::string& path)
+{
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) return -1;
+
+    path.erase((slash > 0) ? slash : 1);
+    return 0;
+}
+
+/* The directories not given on the command line, from the location of the
+   sweep binary, which make builds in sim/build */
+static int find_dirs(const char* prog)
+{
+    std::string dir;
+
+    if (options.Build == NULL || options.Source == NULL)
+    {
+        char* path = realpath(prog, NULL);
+        if (path == NULL) return -1;
+
+        dir = path;
+        free(path);
+
+        if (parent(dir) != 0) return -1;
+    }
+
+    build_dir = (options.Build != NULL) ? options.Build : dir;
+
+    if (options.Source != NULL) source = options.Source;
+    else
+    {
+        source = dir;
+        if (parent(source) != 0) return -1;
+    }
+
+    return 0;
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] grid trace...\n"
+            "  -j <jobs>   parallel compilations and replays (default: one\n"
+            "              per core)\n"
+            "  -B <dir>    directory of main.o and simulator.o (default: the\n"
+            "              directory of this program), the simulators are\n"
+            "              built in <dir>/configs\n"
+            "  -S <dir>    sim/ directory of the sources (default: the\n"
+            "              parent of the directory of this program)\n"
+            "  -o <file>   writes the table to the file instead of stdout\n"
+            "CXX and CXXFLAGS are taken from the environment.\n",
+            prog);
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:B:S:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j': options.Jobs = atoi(optarg); break;
+        case 'B': options.Build = optarg; break;
+        case 'S': options.Source = optarg; break;
+        case 'o': options.Output = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (argc - optind < 2 || options.Jobs < 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (find_dirs(argv[0]) != 0)
+    {
+        fprintf(stderr, "Cannot find the directories of %s, use -B and -S\n",
+                argv[0]);
+        return 1;
+    }
+
+    const char* grid = argv[optind];
+    if (read_grid(grid) != 0) return 1;
+
+    for (int i = optind + 1; i < argc; ++i)
+        traces.push_back(argv[i]);
+
+    std::string dir = build_dir + "/configs";
+    mkdir(dir.c_str(), 0777);
+
+    if (options.Jobs == 0) options.Jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (options.Jobs <= 0) options.Jobs = 1;
+
+    workers.resize(options.Jobs);
+    for (int i = 0; i < options.Jobs; ++i)
+    {
+        pthread_mutex_init(&workers[i].Lock, NULL);
+        workers[i].Index = i;
+    }
+
+    SweepResult empty = SweepResult();
+    results.assign((configs.size() + 1) * traces.size(), empty);
+
+    std::vector<Task> tasks;
+
+    for (size_t c = 0; c < configs.size(); ++c)
+    {
+        Task task = { Task::BUILD, (int)c, 0 };
+        tasks.push_back(task);
+    }
+
+    run_all(tasks);
+    tasks.clear();
+
+    for (size_t t = 0; t < traces.size(); ++t)
+    {
+        Task task = { Task::BASELINE, 0, (int)t };
+        tasks.push_back(task);
+    }
+
+    for (size_t c = 0; c < configs.size(); ++c)
+    {
+        for (size_t t = 0; t < traces.size(); ++t)
+        {
+            Task task = { Task::REPLAY, (int)c, (int)t };
+            tasks.push_back(task);
+        }
+    }
+
+    run_all(tasks);
+
+    FILE* file = stdout;
+    if (options.Output != NULL && (file = fopen(options.Output, "w")) == NULL)
+    {
+        fprintf(stderr, "Cannot open %s\n", options.Output);
+        return 1;
+    }
+
+    print_table(file, grid);
+    if (file != stdout) fclose(file);
+
+    for (size_t i = 0; i < results.size(); ++i)
+        if (!results[i].Valid) return 1;
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Checks that the prefetcher instances linked with it are independent: the
+ * trace replayed by several simulators, interleaved in one thread and in
+ * concurrent threads, must give the same statistics as a replay alone. So
+ * must a replay in batches.
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+
+#include <pthread.h>
+
+#include "simulator.hh"
+
+#define NUM_THREADS 4
+
+static std::vector<TraceRecord> trace;
+
+static void replay(SimStats& stats)
+{
+    Simulator sim(config, true);
+
+    for (size_t i = 0; i < trace.size(); ++i)
+        sim.Access(trace[i]);
+
+    sim.Finish(stats);
+}
+
+static void* replay_thread(void* arg)
+{
+    replay(*(SimStats*)arg);
+    return NULL;
+}
+
+static bool check(const char* name, const SimStats& stats,
+                  const SimStats& ref)
+{
+    if (memcmp(&stats, &ref, sizeof(stats)) == 0) return true;
+
+    std::cout << name << ": " << stats.Issued << " prefetches issued, "
+              << stats.Misses << " misses instead of " << ref.Issued
+              << " and " << ref.Misses << std::endl;
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    TraceReader reader;
+    if (argc < 2 || !reader.Open(argv[1])) return 1;
+
+    TraceRecord rec;
+    while (reader.Next(rec)) trace.push_back(rec);
+
+    if (!prefetch_create)
+    {
+        std::cout << "No prefetcher instances" << std::endl;
+        return 1;
+    }
+
+    SimStats ref;
+    replay(ref);
+
+    bool ok = true;
+
+    /* Two caches, one access to each in turn */
+    {
+        Simulator a(config, true), b(config, true);
+        SimStats statsA, statsB;
+
+        for (size_t i = 0; i < trace.size(); ++i)
+        {
+            a.Access(trace[i]);
+            b.Access(trace[i]);
+        }
+
+        a.Finish(statsA);
+        b.Finish(statsB);
+
+        ok = check("interleaved", statsA, ref) && ok;
+        ok = check("interleaved", statsB, ref) && ok;
+    }
+
+    /* Batches of every size up to a few of the simulator */
+    {
+        Simulator sim(config, true);
+        SimStats stats;
+        size_t size = 1;
+
+        for (size_t i = 0; i < trace.size(); i += size)
+        {
+            size = size % (3 * SIM_BATCH_SIZE) + 1;
+            if (size > trace.size() - i) size = trace.size() - i;
+
+            sim.Access(&trace[i], (int)size);
+        }
+
+        sim.Finish(stats);
+        ok = check("batches", stats, ref) && ok;
+    }
+
+    /* One cache per thread */
+    pthread_t threads[NUM_THREADS];
+    SimStats stats[NUM_THREADS];
+
+    for (int i = 0; i < NUM_THREADS; ++i)
+        pthread_create(&threads[i], NULL, replay_thread, &stats[i]);
+
+    for (int i = 0; i < NUM_THREADS; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        ok = check("threads", stats[i], ref) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
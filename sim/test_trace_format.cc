@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <stdint.h>
+
+#include "trace_format.hh"
+
+#define NUM_RECORDS (3 * TRACE_BLOCK_RECORDS + 123)
+
+TraceRecord make_record(int i)
+{
+    TraceRecord rec;
+
+    rec.Time = (int64_t)i * 500 + (i % 7);
+    rec.Pc = 0x400000 + (i % 13) * 4;
+    rec.Addr = (i % 3 == 0) ? 0x100000 + (uint64_t)i * 64
+                            : ((uint64_t)rand() << 20) ^ rand();
+    rec.Miss = (i % 5 != 0);
+
+    if (i == 17) rec.Addr = ~(uint64_t)0;
+    if (i == 18) rec.Time = 0;
+
+    return rec;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <scratch trace file>"
+                  << std::endl;
+        return 1;
+    }
+
+    const char* path = argv[1];
+
+    srand(1);
+    TraceWriter writer;
+    if (!writer.Open(path)) return 1;
+    for (int i = 0; i < NUM_RECORDS; ++i) writer.Append(make_record(i));
+    writer.Close();
+
+    srand(1);
+    MappedTraceReader reader;
+    if (!reader.Open(path)) return 1;
+
+    TraceRecord rec;
+    int count = 0;
+
+    while (reader.Next(rec))
+    {
+        TraceRecord ref = make_record(count);
+
+        if (rec.Time != ref.Time || rec.Pc != ref.Pc ||
+            rec.Addr != ref.Addr || rec.Miss != ref.Miss)
+        {
+            std::cout << "Mismatch at record " << count << std::endl;
+            return 1;
+        }
+
+        ++count;
+    }
+
+    std::cout << "Decoded " << count << " records in "
+              << reader.Header().BlockCount << " blocks" << std::endl;
+
+    return (count == NUM_RECORDS &&
+            reader.Header().RecordCount == NUM_RECORDS) ? 0 : 1;
+}
@@ -0,0 +1,371 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Compact binary format for AccessStat streams.
+ *
+ *   FileHeader
+ *   BlockHeader, payload
+ *   BlockHeader, payload
+ *   ...
+ *
+ * Records are grouped in blocks of at most TRACE_BLOCK_RECORDS records. In a
+ * block every record is stored as three varints, each field being the
+ * zig-zag encoded difference to the same field of the previous record:
+ *
+ *   ((dtime << 1) | miss), dpc, daddr
+ *
+ * The delta state is reset at the beginning of every block, so that blocks
+ * can be decoded independently and only one block ever has to be resident.
+ * The header counters are patched when the writer is closed; readers do not
+ * rely on them and simply walk the blocks until the end of the file.
+ */
+
+#pragma once
+
+#include "trace_reader.hh"
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TRACE_MAGIC         "PFTRACE1"
+#define TRACE_BLOCK_RECORDS 65536
+#define TRACE_MAX_RECORD    30 /* 3 varints of at most 10 bytes */
+
+struct TraceFileHeader
+{
+    char Magic[8];
+    uint32_t BlockRecords;
+    uint32_t Reserved;
+    uint64_t RecordCount;
+    uint64_t BlockCount;
+};
+
+struct TraceBlockHeader
+{
+    uint32_t Records;
+    uint32_t Bytes;
+};
+
+/* ------------------------------------------------------- Varint encoding */
+inline uint64_t TraceZigZag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+inline int64_t TraceUnZigZag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+inline uint8_t* TracePutVarint(uint8_t* p, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+/* Returns NULL if the varint runs past `end` */
+inline const uint8_t* TraceGetVarint(const uint8_t* p, const uint8_t* end,
+                                     uint64_t& value)
+{
+    value = 0;
+
+    for (int shift = 0; p < end && shift < 64; shift += 7)
+    {
+        uint8_t byte = *p++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return p;
+    }
+
+    return NULL;
+}
+
+/* ----------------------------------------------------------------- Writer */
+class TraceWriter
+{
+private:
+    FILE* mFile;
+    TraceFileHeader mHeader;
+
+    std::vector<uint8_t> mBlock;
+    size_t mBlockBytes;
+    uint32_t mBlockRecords;
+    TraceRecord mPrev;
+
+public:
+    TraceWriter() : mFile(NULL), mBlockBytes(0), mBlockRecords(0) { }
+    ~TraceWriter() { Close(); }
+
+    bool Open(const char* path)
+    {
+        Close();
+
+        mFile = fopen(path, "wb");
+        if (mFile == NULL) return false;
+
+        memset(&mHeader, 0, sizeof(mHeader));
+        memcpy(mHeader.Magic, TRACE_MAGIC, sizeof(mHeader.Magic));
+        mHeader.BlockRecords = TRACE_BLOCK_RECORDS;
+
+        mBlock.resize(TRACE_BLOCK_RECORDS * TRACE_MAX_RECORD);
+        ResetBlock();
+
+        return fwrite(&mHeader, sizeof(mHeader), 1, mFile) == 1;
+    }
+
+    void Append(const TraceRecord& rec)
+    {
+        if (mFile == NULL) return;
+
+        uint8_t* p = &mBlock[mBlockBytes];
+
+        p = TracePutVarint(p, (TraceZigZag(rec.Time - mPrev.Time) << 1) |
+                              (rec.Miss ? 1 : 0));
+        p = TracePutVarint(p, TraceZigZag((int64_t)(rec.Pc - mPrev.Pc)));
+        p = TracePutVarint(p, TraceZigZag((int64_t)(rec.Addr - mPrev.Addr)));
+
+        mBlockBytes = p - &mBlock[0];
+        mPrev = rec;
+
+        if (++mBlockRecords == TRACE_BLOCK_RECORDS) Flush();
+    }
+
+    void Close()
+    {
+        if (mFile == NULL) return;
+
+        Flush();
+
+        /* Patches the counters of the header */
+        fseek(mFile, 0, SEEK_SET);
+        fwrite(&mHeader, sizeof(mHeader), 1, mFile);
+        fclose(mFile);
+
+        mFile = NULL;
+    }
+
+private:
+    void ResetBlock()
+    {
+        mBlockBytes = 0;
+        mBlockRecords = 0;
+        memset(&mPrev, 0, sizeof(mPrev));
+    }
+
+    void Flush()
+    {
+        if (mBlockRecords == 0) return;
+
+        TraceBlockHeader block;
+        block.Records = mBlockRecords;
+        block.Bytes = (uint32_t)mBlockBytes;
+
+        fwrite(&block, sizeof(block), 1, mFile);
+        fwrite(&mBlock[0], 1, mBlockBytes, mFile);
+
+        mHeader.RecordCount += mBlockRecords;
+        ++mHeader.BlockCount;
+
+        ResetBlock();
+    }
+};
+
+/* ----------------------------------------------------------------- Reader */
+/**
+ * Memory-mapped reader. Blocks are decoded in place while walking the
+ * mapping, and the pages of the blocks already consumed are released, so
+ * the resident size stays bounded whatever the trace length is.
+ */
+class MappedTraceReader
+{
+private:
+    int mFd;
+    const uint8_t* mBase;
+    size_t mSize;
+
+    size_t mBlockOffset; /* Offset of the current block header */
+    const uint8_t* mCursor;
+    const uint8_t* mBlockEnd;
+    uint32_t mBlockLeft;
+    size_t mReleased;
+    TraceRecord mPrev;
+
+public:
+    MappedTraceReader()
+        : mFd(-1), mBase(NULL), mSize(0), mBlockOffset(0), mCursor(NULL),
+          mBlockEnd(NULL), mBlockLeft(0), mReleased(0)
+    { }
+
+    ~MappedTraceReader() { Close(); }
+
+    static bool IsBinaryTrace(const char* path)
+    {
+        char magic[8];
+        FILE* file = fopen(path, "rb");
+        if (file == NULL) return false;
+
+        bool ret = (fread(magic, sizeof(magic), 1, file) == 1 &&
+                    memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0);
+        fclose(file);
+        return ret;
+    }
+
+    bool Open(const char* path)
+    {
+        Close();
+
+        mFd = open(path, O_RDONLY);
+        if (mFd < 0) return false;
+
+        struct stat st;
+        if (fstat(mFd, &st) != 0 || (size_t)st.st_size < sizeof(TraceFileHeader))
+        {
+            Close();
+            return false;
+        }
+
+        mSize = st.st_size;
+        void* base = mmap(NULL, mSize, PROT_READ, MAP_PRIVATE, mFd, 0);
+        if (base == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+
+        mBase = (const uint8_t*)base;
+        madvise(base, mSize, MADV_SEQUENTIAL);
+
+        if (memcmp(mBase, TRACE_MAGIC, 8) != 0)
+        {
+            Close();
+            return false;
+        }
+
+        mBlockOffset = sizeof(TraceFileHeader);
+        mCursor = NULL;
+        mBlockLeft = 0;
+        mReleased = 0;
+        return true;
+    }
+
+    void Close()
+    {
+        if (mBase != NULL) munmap((void*)mBase, mSize);
+        if (mFd >= 0) close(mFd);
+
+        mBase = NULL;
+        mFd = -1;
+    }
+
+    const TraceFileHeader& Header() const
+    {
+        return *(const TraceFileHeader*)mBase;
+    }
+
+    bool Next(TraceRecord& rec)
+    {
+        if (mBlockLeft == 0 && !NextBlock()) return false;
+
+        uint64_t time, pc, addr;
+
+        mCursor = TraceGetVarint(mCursor, mBlockEnd, time);
+        if (mCursor != NULL) mCursor = TraceGetVarint(mCursor, mBlockEnd, pc);
+        if (mCursor != NULL) mCursor = TraceGetVarint(mCursor, mBlockEnd, addr);
+
+        if (mCursor == NULL)
+        {
+            fprintf(stderr, "Corrupted trace block at offset %zu\n",
+                    mBlockOffset);
+            mBlockLeft = 0;
+            mBlockOffset = mSize;
+            return false;
+        }
+
+        rec.Time = mPrev.Time + TraceUnZigZag(time >> 1);
+        rec.Miss = (int)(time & 1);
+        rec.Pc = mPrev.Pc + (uint64_t)TraceUnZigZag(pc);
+        rec.Addr = mPrev.Addr + (uint64_t)TraceUnZigZag(addr);
+
+        mPrev = rec;
+        --mBlockLeft;
+        return true;
+    }
+
+private:
+    bool NextBlock()
+    {
+        if (mCursor != NULL)
+        {
+            mBlockOffset = mBlockEnd - mBase;
+            Release(mBlockOffset);
+        }
+
+        if (mBlockOffset + sizeof(TraceBlockHeader) > mSize) return false;
+
+        TraceBlockHeader block;
+        memcpy(&block, mBase + mBlockOffset, sizeof(block));
+
+        if (mBlockOffset + sizeof(block) + block.Bytes > mSize) return false;
+
+        mCursor = mBase + mBlockOffset + sizeof(block);
+        mBlockEnd = mCursor + block.Bytes;
+        mBlockLeft = block.Records;
+        memset(&mPrev, 0, sizeof(mPrev));
+
+        return mBlockLeft > 0;
+    }
+
+    /* Drops the pages that lie entirely before `offset` */
+    void Release(size_t offset)
+    {
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t end = offset & ~(page - 1);
+
+        if (end > mReleased)
+        {
+            madvise((void*)(mBase + mReleased), end - mReleased, MADV_DONTNEED);
+            mReleased = end;
+        }
+    }
+};
+
+/* ------------------------------------------------------------ Any format */
+class TraceReader
+{
+private:
+    bool mBinary;
+    TextTraceReader mText;
+    MappedTraceReader mMapped;
+
+public:
+    TraceReader() : mBinary(false) { }
+
+    bool Open(const char* path)
+    {
+        mBinary = MappedTraceReader::IsBinaryTrace(path);
+        return mBinary ? mMapped.Open(path) : mText.Open(path);
+    }
+
+    bool Next(TraceRecord& rec)
+    {
+        return mBinary ? mMapped.Next(rec) : mText.Next(rec);
+    }
+};
@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+#include <cinttypes>
+
+struct TraceRecord
+{
+    uint64_t Pc;
+    uint64_t Addr;
+    int64_t Time;
+    int Miss;
+};
+
+/**
+ * Reads a text trace, one access per line:
+ *
+ *   <time> <pc> <addr> [miss]
+ *
+ * Time is decimal, pc and addr are hexadecimal (with or without 0x). Empty
+ * lines and lines starting with '#' are ignored.
+ */
+class TextTraceReader
+{
+private:
+    FILE* mFile;
+
+public:
+    TextTraceReader() : mFile(NULL) { }
+    ~TextTraceReader() { Close(); }
+
+    bool Open(const char* path)
+    {
+        Close();
+        mFile = fopen(path, "r");
+        return mFile != NULL;
+    }
+
+    void Close()
+    {
+        if (mFile != NULL) fclose(mFile);
+        mFile = NULL;
+    }
+
+    bool Next(TraceRecord& rec)
+    {
+        char line[256];
+
+        while (fgets(line, sizeof(line), mFile) != NULL)
+        {
+            if (line[0] == '#' || line[0] == '\n') continue;
+
+            rec.Miss = 0;
+            if (sscanf(line, "%" SCNd64 " %" SCNx64 " %" SCNx64 " %d",
+                       &rec.Time, &rec.Pc, &rec.Addr, &rec.Miss) >= 3)
+                return true;
+        }
+
+        return false;
+    }
+};
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Converts traces between the text and the binary format, and prints
+ * information about binary traces.
+ */
+
+#include "trace_format.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+
+static int encode(const char* in, const char* out)
+{
+    TraceReader reader;
+    TraceWriter writer;
+
+    if (!reader.Open(in)) { fprintf(stderr, "Cannot open %s\n", in); return 1; }
+    if (!writer.Open(out)) { fprintf(stderr, "Cannot open %s\n", out); return 1; }
+
+    TraceRecord rec;
+    while (reader.Next(rec))
+        writer.Append(rec);
+
+    writer.Close();
+    return 0;
+}
+
+static int decode(const char* in, const char* out)
+{
+    TraceReader reader;
+
+    if (!reader.Open(in)) { fprintf(stderr, "Cannot open %s\n", in); return 1; }
+
+    FILE* file = (strcmp(out, "-") == 0) ? stdout : fopen(out, "w");
+    if (file == NULL) { fprintf(stderr, "Cannot open %s\n", out); return 1; }
+
+    TraceRecord rec;
+    while (reader.Next(rec))
+        fprintf(file, "%" PRId64 " %" PRIx64 " %" PRIx64 " %d\n",
+                rec.Time, rec.Pc, rec.Addr, rec.Miss);
+
+    if (file != stdout) fclose(file);
+    return 0;
+}
+
+static int info(const char* in)
+{
+    MappedTraceReader reader;
+
+    if (!reader.Open(in)) { fprintf(stderr, "Cannot open %s\n", in); return 1; }
+
+    const TraceFileHeader& header = reader.Header();
+    uint64_t records = 0, misses = 0;
+
+    TraceRecord rec;
+    while (reader.Next(rec))
+    {
+        ++records;
+        misses += rec.Miss;
+    }
+
+    printf("records: %" PRIu64 " (header: %" PRIu64 ")\n",
+           records, header.RecordCount);
+    printf("blocks:  %" PRIu64 " of at most %u records\n",
+           header.BlockCount, header.BlockRecords);
+    printf("misses:  %" PRIu64 "\n", misses);
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 4 && strcmp(argv[1], "encode") == 0)
+        return encode(argv[2], argv[3]);
+    if (argc == 4 && strcmp(argv[1], "decode") == 0)
+        return decode(argv[2], argv[3]);
+    if (argc == 3 && strcmp(argv[1], "info") == 0)
+        return info(argv[2]);
+
+    fprintf(stderr,
+            "Usage: %s encode <trace> <out.pft>\n"
+            "       %s decode <trace> <out.txt|->\n"
+            "       %s info <trace.pft>\n",
+            argv[0], argv[0], argv[0]);
+    return 1;
+}
@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   Stephen Somogyi, Thomas F. Wenisch, Anastassia Ailamaki, Babak Falsafi,
+ *     Andreas Moshovos, "Spatial Memory Streaming", ISCA 2006
+ *
+ * Spatial memory streaming: the footprint of the blocks accessed in a
+ * SMS_REGION_SIZE region during a generation is learned under the PC and
+ * the offset of the access which started it, and the next access with the
+ * same PC and offset to a fresh region prefetches the whole footprint.
+ */
+
+#include "interface.hh"
+
+/* ---------------------------------------------------------------- Logging */
+#include "prefetch_log.hh"
+
+/* --------------------------------------------------------------- Pipeline */
+#include "prefetch_pipeline.hh"
+#include "prefetch_instances.hh"
+#include "stage_sms.hh"
+
+typedef PrefetchPipeline<SmsTrainer, SmsPredictor> Prefetcher;
+
+PrefetcherInstances<Prefetcher> prefetchers;
+
+/* --------------------------------- Standard hardware prefetcher interface */
+void prefetch_init(void)
+{
+    LOGD("prefetch_init");
+
+    prefetchers.Current().Init();
+}
+
+void prefetch_access(AccessStat stat)
+{
+    LOG_SET_TIME(stat.time);
+
+    LOGD("prefetch_access: addr = 0x%016x, pc = 0x%016x, miss = %d",
+         stat.mem_addr, stat.pc, stat.miss);
+
+    prefetchers.Current().Access(stat);
+}
+
+void prefetch_complete(Addr addr)
+{
+    LOGD("prefetch_complete: addr = 0x%016x, current_queue_size = %d",
+         addr, current_queue_size());
+
+    prefetchers.Current().Complete(addr);
+}
+
+void prefetch_final(void)
+{
+    Prefetcher& prefetcher = prefetchers.Current();
+
+    prefetcher.Print(stderr, "sms");
+    LOG_EVENT_DUMP();
+}
+
+/* Only called by the benchmarks */
+double prefetch_occupancy(void)
+{
+    return prefetchers.Current().Occupancy();
+}
+
+/* Only called by the simulator, same as prefetch_access on every access */
+void prefetch_access_batch(const AccessBatch& batch, AccessDemand demand,
+                           void* context)
+{
+    prefetchers.Current().Access(batch, demand, context);
+}
+
+/* Only called by the simulator, which creates an instance per cache */
+PREFETCH_INSTANCE_FUNCTIONS(prefetchers)
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Reference:
+ *   Alan Jay Smith, "Sequential Program Prefetching in Memory Hierarchies",
+ *     Computer, vol. 11, no. 12, pp. 7-21, Dec. 1978
+ *   Fredrik Dahlgren, Michel Dubois, Per Stenstrom, "Fixed and Adaptive
+ *     Sequential Prefetching in Shared Memory Multiprocessors", ICPP 1993
+ *
+ * Tagged sequential prefetching over several streams: a miss or the first
+ * hit on a prefetched block continues its stream, whose degree doubles on
+ * every such trigger up to STREAM_MAX_DEGREE.
+ */
+
+#include "interface.hh"
+
+/* ---------------------------------------------------------------- Logging */
+#include "prefetch_log.hh"
+
+/* --------------------------------------------------------------- Pipeline */
+#include "prefetch_pipeline.hh"
+#include "prefetch_instances.hh"
+#include "stage_stream.hh"
+
+typedef PrefetchPipeline<StreamTrainer, StreamPredictor> Prefetcher;
+
+PrefetcherInstances<Prefetcher> prefetchers;
+
+/* --------------------------------- Standard hardware prefetcher interface */
+void prefetch_init(void)
+{
+    LOGD("prefetch_init");
+
+    prefetchers.Current().Init();
+}
+
+void prefetch_access(AccessStat stat)
+{
+    LOG_SET_TIME(stat.time);
+
+    LOGD("prefetch_access: addr = 0x%016x, pc = 0x%016x, miss = %d",
+         stat.mem_addr, stat.pc, stat.miss);
+
+    prefetchers.Current().Access(stat);
+}
+
+void prefetch_complete(Addr addr)
+{
+    LOGD("prefetch_complete: addr = 0x%016x, current_queue_size = %d",
+         addr, current_queue_size());
+
+    prefetchers.Current().Complete(addr);
+}
+
+void prefetch_final(void)
+{
+    Prefetcher& prefetcher = prefetchers.Current();
+
+    const StreamTrainer& streams = prefetcher.GetTrainer();
+
+    fprintf(stderr, "tagged-stream: %llu streams, %llu tagged hits\n",
+            (unsigned long long)streams.Allocated(),
+            (unsigned long long)streams.TaggedHits());
+
+    prefetcher.Print(stderr, "tagged-stream");
+    LOG_EVENT_DUMP();
+}
+
+/* Only called by the benchmarks */
+double prefetch_occupancy(void)
+{
+    return prefetchers.Current().Occupancy();
+}
+
+/* Only called by the simulator, same as prefetch_access on every access */
+void prefetch_access_batch(const AccessBatch& batch, AccessDemand demand,
+                           void* context)
+{
+    prefetchers.Current().Access(batch, demand, context);
+}
+
+/* Only called by the simulator, which creates an instance per cache */
+PREFETCH_INSTANCE_FUNCTIONS(prefetchers)
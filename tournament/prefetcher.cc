@@ -0,0 +1,305 @@
+/**
+ * Copyright (c) 2017 Viet-Hoa Do <viethoad[at]stud.ntnu.no>
+ *                    Martin Stypinski <mstypinski[at]gmail.com>
+ * All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ *
+ * Tournament between the stride (baer91), Markov (joseph97) and next-line
+ * (one-block-lookahead) predictors.
+ *
+ * All three are trained and predict on every access, but only the
+ * candidates of the current winner of the triggering PC are issued. The
+ * candidates of every predictor are remembered in a shadow buffer of that
+ * predictor, with the PC which triggered them: a demand access to one of
+ * them scores a point for the predictor at that PC, and a candidate
+ * evicted from the buffer without being accessed costs one.
+ *
+ * Only the predictors which have produced candidates at a PC compete
+ * there, as a silent predictor would otherwise keep its initial score and
+ * beat any useful one. A tie goes to the predictor with the most hits at
+ * the PC.
+ */
+
+#include "interface.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+/* Candidates remembered per predictor, direct-mapped */
+#define SHADOW_SIZE     1024
+
+/* PCs whose scores are tracked, direct-mapped */
+#define SCORE_ENTRIES   256
+
+/* Saturating score of every predictor at every PC */
+#define SCORE_MAX       15
+#define SCORE_INIT      8
+
+/* ---------------------------------------------------------------- Logging */
+#include "prefetch_log.hh"
+
+/* --------------------------------------------------------------- Pipeline */
+#include "prefetch_pipeline.hh"
+#include "prefetch_instances.hh"
+#include "stage_stride.hh"
+#include "stage_markov.hh"
+#include "stage_next_line.hh"
+
+/* ------------------------------------------------------------- Tournament */
+enum { PRED_STRIDE, PRED_MARKOV, PRED_NEXT_LINE, NUM_PREDICTORS };
+
+const char* predictor_names[NUM_PREDICTORS] =
+    { "stride", "markov", "next-line" };
+
+struct shadow_entry_t
+{
+    Addr block;
+    Addr pc; /* PC whose access triggered the candidate, 0 if free */
+};
+
+struct score_entry_t
+{
+    Addr pc;
+    uint8_t score[NUM_PREDICTORS];
+    uint8_t hits[NUM_PREDICTORS];      /* Saturating */
+    uint8_t predicted[NUM_PREDICTORS]; /* Has produced candidates here */
+};
+
+/* The tables of one prefetcher instance */
+struct tournament_t
+{
+    shadow_entry_t shadow[NUM_PREDICTORS][SHADOW_SIZE];
+    score_entry_t scores[SCORE_ENTRIES];
+
+    uint64_t wins[NUM_PREDICTORS];  /* Accesses won by every predictor */
+    uint64_t hits[NUM_PREDICTORS];  /* Candidates accessed by the program */
+};
+
+score_entry_t& score_entry(tournament_t& t, Addr pc)
+{
+    score_entry_t& entry = t.scores[(pc >> 2) % SCORE_ENTRIES];
+
+    if (entry.pc != pc)
+    {
+        entry.pc = pc;
+        for (int i = 0; i < NUM_PREDICTORS; ++i)
+        {
+            entry.score[i] = SCORE_INIT;
+            entry.hits[i] = 0;
+            entry.predicted[i] = 0;
+        }
+    }
+
+    return entry;
+}
+
+void score_update(tournament_t& t, Addr pc, int pred, bool useful)
+{
+    score_entry_t& entry = score_entry(t, pc);
+    uint8_t& score = entry.score[pred];
+
+    if (useful)
+    {
+        if (score < SCORE_MAX) ++score;
+        if (entry.hits[pred] < 255) ++entry.hits[pred];
+    }
+    else if (score > 0) --score;
+}
+
+/* Whether predictor a beats predictor b at the PC */
+bool score_better(const score_entry_t& entry, int a, int b)
+{
+    if (entry.predicted[a] != entry.predicted[b]) return entry.predicted[a];
+    if (entry.score[a] != entry.score[b])
+        return entry.score[a] > entry.score[b];
+    return entry.hits[a] > entry.hits[b];
+}
+
+/* The predictor with the best score among those which have produced
+   candidates at the PC, the one with the most hits on a tie */
+int tournament_winner(tournament_t& t, Addr pc)
+{
+    score_entry_t& entry = score_entry(t, pc);
+    int winner = 0;
+
+    for (int i = 1; i < NUM_PREDICTORS; ++i)
+        if (score_better(entry, i, winner)) winner = i;
+
+    return winner;
+}
+
+shadow_entry_t& shadow_slot(tournament_t& t, int pred, Addr block)
+{
+    return t.shadow[pred][(block / BLOCK_SIZE) % SHADOW_SIZE];
+}
+
+/* Scores the predictors which predicted this demand access */
+void tournament_access(tournament_t& t, Addr block)
+{
+    for (int i = 0; i < NUM_PREDICTORS; ++i)
+    {
+        shadow_entry_t& entry = shadow_slot(t, i, block);
+        if (entry.pc == 0 || entry.block != block) continue;
+
+        score_update(t, entry.pc, i, true);
+        ++t.hits[i];
+        entry.pc = 0;
+    }
+}
+
+void tournament_record(tournament_t& t, int pred, Addr block, Addr pc)
+{
+    shadow_entry_t& entry = shadow_slot(t, pred, block);
+
+    /* Replaces a candidate which was never accessed */
+    if (entry.pc != 0 && entry.block != block)
+        score_update(t, entry.pc, pred, false);
+
+    entry.block = block;
+    entry.pc = pc;
+
+    score_entry(t, pc).predicted[pred] = 1;
+}
+
+/* Records the candidates of one predictor, and only forwards them to the
+   pipeline if that predictor is the winner */
+template <class Sink>
+class ShadowSink
+{
+private:
+    Sink& mSink;
+    tournament_t& mTournament;
+    int mPredictor;
+    Addr mPc;
+    bool mIssue;
+
+public:
+    ShadowSink(Sink& sink, tournament_t& tournament, int predictor, Addr pc,
+               bool issue)
+        : mSink(sink), mTournament(tournament), mPredictor(predictor),
+          mPc(pc), mIssue(issue)
+    { }
+
+    int Degree(int max) const { return mSink.Degree(max); }
+
+    bool Push(Addr addr, int priority)
+    {
+        /* Blocks already cached would be scored for nothing */
+        if (in_cache(addr)) return false;
+
+        tournament_record(mTournament, mPredictor, addr, mPc);
+        return mIssue ? mSink.Push(addr, priority) : true;
+    }
+};
+
+typedef CombinedTrainer<RptTrainer,
+                        CombinedTrainer<MarkovTrainer, NullTrainer> >
+        TournamentTrainer;
+
+class TournamentPredictor
+{
+private:
+    LookaheadPredictor mStride;
+    MarkovPredictor mMarkov;
+    NextLinePredictor mNextLine;
+    tournament_t mTournament;
+
+public:
+    void Init()
+    {
+        mStride.Init();
+        mMarkov.Init();
+        mNextLine.Init();
+
+        memset(&mTournament, 0, sizeof(mTournament));
+    }
+
+    template <class Sink>
+    void Predict(const AccessStat& stat, Addr block,
+                 TournamentTrainer& trainer, Sink& sink)
+    {
+        tournament_access(mTournament, block);
+
+        int winner = tournament_winner(mTournament, stat.pc);
+        ++mTournament.wins[winner];
+
+        ShadowSink<Sink> stride(sink, mTournament, PRED_STRIDE, stat.pc,
+                                winner == PRED_STRIDE);
+        mStride.Predict(stat, block, trainer.First, stride);
+
+        ShadowSink<Sink> markov(sink, mTournament, PRED_MARKOV, stat.pc,
+                                winner == PRED_MARKOV);
+        mMarkov.Predict(stat, block, trainer.Second.First, markov);
+
+        ShadowSink<Sink> next_line(sink, mTournament, PRED_NEXT_LINE,
+                                   stat.pc, winner == PRED_NEXT_LINE);
+        mNextLine.Predict(stat, block, trainer.Second.Second, next_line);
+    }
+
+    void Print(FILE* file) const
+    {
+        for (int i = 0; i < NUM_PREDICTORS; ++i)
+            fprintf(file, "tournament: %s wins = %llu, hits = %llu\n",
+                    predictor_names[i],
+                    (unsigned long long)mTournament.wins[i],
+                    (unsigned long long)mTournament.hits[i]);
+    }
+};
+
+typedef PrefetchPipeline<TournamentTrainer, TournamentPredictor> Prefetcher;
+
+PrefetcherInstances<Prefetcher> prefetchers;
+
+/* --------------------------------- Standard hardware prefetcher interface */
+void prefetch_init(void)
+{
+    LOGD("prefetch_init");
+
+    prefetchers.Current().Init();
+}
+
+void prefetch_access(AccessStat stat)
+{
+    LOG_SET_TIME(stat.time);
+
+    LOGD("prefetch_access: addr = 0x%016x, pc = 0x%016x, miss = %d",
+         stat.mem_addr, stat.pc, stat.miss);
+
+    prefetchers.Current().Access(stat);
+}
+
+void prefetch_complete(Addr addr)
+{
+    LOGD("prefetch_complete: addr = 0x%016x, current_queue_size = %d",
+         addr, current_queue_size());
+
+    prefetchers.Current().Complete(addr);
+}
+
+void prefetch_final(void)
+{
+    Prefetcher& prefetcher = prefetchers.Current();
+
+    prefetcher.GetPredictor().Print(stderr);
+    prefetcher.Print(stderr, "tournament");
+    LOG_EVENT_DUMP();
+}
+
+/* Only called by the benchmarks */
+double prefetch_occupancy(void)
+{
+    return prefetchers.Current().Occupancy();
+}
+
+/* Only called by the simulator, same as prefetch_access on every access */
+void prefetch_access_batch(const AccessBatch& batch, AccessDemand demand,
+                           void* context)
+{
+    prefetchers.Current().Access(batch, demand, context);
+}
+
+/* Only called by the simulator, which creates an instance per cache */
+PREFETCH_INSTANCE_FUNCTIONS(prefetchers)